@@ -0,0 +1,185 @@
+#ifndef AUTOTUNE_HPP
+#define AUTOTUNE_HPP
+
+#include <sycl/sycl.hpp>
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace sycl;
+
+/**
+ * launch configuration of the nd_range VectorAdd: work-group size, number of
+ * vectors every work-item handles and the sycl::vec width of the loads
+ */
+struct launch_params
+{
+  size_t wg_size = 256;
+  int items_per_wi = 1;
+  int vec_width = 1;
+};
+
+/**
+ * nd_range VectorAdd with vec<int, N> loads and stores. work-item gid
+ * handles vectors gid, gid + global, gid + 2 * global, ... so neighbouring
+ * work-items of a sub-group always touch neighbouring vectors. the
+ * size % N tail is done element-wise, strided by global like the vectors
+ */
+template<int N>
+event VectorAddND(queue &q, const int *a, const int *b, int *sum, size_t size, launch_params p)
+{
+  size_t nvec = size / N;
+  size_t work_items = (nvec + p.items_per_wi - 1) / p.items_per_wi;
+  size_t global = std::max<size_t>(1, (work_items + p.wg_size - 1) / p.wg_size) * p.wg_size;
+  int items = p.items_per_wi;
+
+  return q.parallel_for(nd_range<1>{range<1>{global}, range<1>{p.wg_size}}, [=](nd_item<1> it) {
+    size_t gid = it.get_global_id(0);
+    auto pa = address_space_cast<access::address_space::global_space, access::decorated::no>(a);
+    auto pb = address_space_cast<access::address_space::global_space, access::decorated::no>(b);
+    auto ps = address_space_cast<access::address_space::global_space, access::decorated::no>(sum);
+    for (int k = 0; k < items; k++)
+    {
+      size_t v = gid + k * global;
+      if (v < nvec)
+      {
+        vec<int, N> va, vb;
+        va.load(v, pa);
+        vb.load(v, pb);
+        vec<int, N> vs = va + vb;
+        vs.store(v, ps);
+      }
+    }
+    //the tail can be longer than global when wg_size < N
+    for (size_t tail = nvec * N + gid; tail < size; tail += global) sum[tail] = a[tail] + b[tail];
+  });
+}
+
+inline event VectorAddND(queue &q, const int *a, const int *b, int *sum, size_t size, launch_params p)
+{
+  switch (p.vec_width)
+  {
+    case 2: return VectorAddND<2>(q, a, b, sum, size, p);
+    case 4: return VectorAddND<4>(q, a, b, sum, size, p);
+    case 8: return VectorAddND<8>(q, a, b, sum, size, p);
+    case 16: return VectorAddND<16>(q, a, b, sum, size, p);
+    default: return VectorAddND<1>(q, a, b, sum, size, p);
+  }
+}
+
+//power-of-two bucket of the vector size, tuned parameters are kept per bucket
+inline int size_class(size_t size)
+{
+  int c = 0;
+  while ((size_t(1) << (c + 1)) <= size) c++;
+  return c;
+}
+
+/**
+ * best launch_params per device name and size class, persisted as
+ * device;size_class;wg_size;items_per_wi;vec_width;time_ns lines
+ */
+class tune_cache
+{
+ public:
+  explicit tune_cache(std::string filename) : filename(filename) { load(); }
+
+  bool lookup(const std::string &device_name, int cls, launch_params &p) const
+  {
+    auto it = entries.find(key(device_name, cls));
+    if (it == entries.end()) return false;
+    p = it->second.first;
+    return true;
+  }
+
+  void store(const std::string &device_name, int cls, launch_params p, double time_ns)
+  {
+    entries[key(device_name, cls)] = {p, time_ns};
+    save();
+  }
+
+ private:
+  static std::string key(const std::string &device_name, int cls)
+  {
+    return device_name + ";" + std::to_string(cls);
+  }
+
+  void load()
+  {
+    std::ifstream in(filename);
+    std::string line;
+    while (std::getline(in, line))
+    {
+      std::stringstream ss(line);
+      std::string name, field;
+      std::vector<std::string> f;
+      std::getline(ss, name, ';');
+      while (std::getline(ss, field, ';')) f.push_back(field);
+      if (f.size() != 5) continue;
+      launch_params p;
+      p.wg_size = std::stoul(f[1]);
+      p.items_per_wi = std::stoi(f[2]);
+      p.vec_width = std::stoi(f[3]);
+      entries[key(name, std::stoi(f[0]))] = {p, std::stod(f[4])};
+    }
+  }
+
+  void save() const
+  {
+    std::ofstream out(filename, std::ios_base::trunc);
+    for (auto &e : entries)
+      out << e.first << ";" << e.second.first.wg_size << ";" << e.second.first.items_per_wi
+          << ";" << e.second.first.vec_width << ";" << e.second.second << std::endl;
+  }
+
+  std::string filename;
+  std::map<std::string, std::pair<launch_params, double>> entries;
+};
+
+/**
+ * exhaustive search over work-group size, items per work-item and vec width
+ * for one size, each candidate timed as the median kernel time of
+ * repetitions runs. returns the fastest and its time in ns, or the default
+ * launch_params and -1 if no candidate could run
+ */
+inline std::pair<launch_params, double> autotune(queue &q, const int *a, const int *b, int *sum,
+                                                 size_t size, int repetitions = 3)
+{
+  size_t max_wg = q.get_device().get_info<info::device::max_work_group_size>();
+  launch_params best;
+  double best_ns = -1;
+
+  for (size_t wg = 32; wg <= std::min<size_t>(max_wg, 1024); wg *= 2)
+    for (int items : {1, 2, 4, 8})
+      for (int width : {1, 2, 4, 8, 16})
+      {
+        launch_params p{wg, items, width};
+        std::vector<double> t;
+        try {
+          VectorAddND(q, a, b, sum, size, p).wait(); // first launch of this N pays for JIT
+          for (int r = 0; r < repetitions; r++)
+          {
+            event e = VectorAddND(q, a, b, sum, size, p);
+            e.wait();
+            t.push_back(e.template get_profiling_info<info::event_profiling::command_end>() -
+                        e.template get_profiling_info<info::event_profiling::command_start>());
+          }
+        } catch (exception const &e) {
+          continue; // configuration not supported by the device
+        }
+        std::sort(t.begin(), t.end());
+        double median = t[t.size() / 2];
+        if (best_ns < 0 || median < best_ns)
+        {
+          best = p;
+          best_ns = median;
+        }
+      }
+  return {best, best_ns};
+}
+
+#endif // AUTOTUNE_HPP
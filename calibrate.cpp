@@ -0,0 +1,237 @@
+#include <sycl/sycl.hpp>
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <fstream>
+#include <thread>
+#include <vector>
+#include <omp.h>
+
+#include "runtime.hpp"
+#include "elementwise.hpp"
+#include "calibration.hpp"
+
+
+using namespace sycl;
+
+/**
+ * Calibration sweep for the split predictor. runs "Sycl only" and
+ * "OpenMP only" VectorAdd over a range of sizes and thread counts (the
+ * points run.sh and run_omp_threads.sh cover with one process each), the
+ * OpenMP side with usm_add's own loop (measure_usm_add_omp), fits
+ * a latency + per-element model to every series and stores the models in
+ * the profile file under the device name. usm_add -s auto reads it.
+ * a second sweep over small sizes finds the crossover below which the
+ * single thread host loop beats every offload route.
+ */
+struct config
+{
+ size_t min_size =256; //number of elements (4 byte int)
+ size_t max_size =1024*1024*256;
+ std::string threads = "1,2,4,8,16";
+ size_t crossover_max =1024*1024; //largest size of the crossover sweep
+ int repetitions =5;
+ std::string device_str = "gpu";
+ std::string profile_file = "coprocessing_profile.csv";
+ std::string filename = "calibration.csv";
+};
+
+/**
+ * -min smallest vector size in elements
+ * -max largest vector size in elements
+ * -xmax largest vector size of the crossover sweep
+ * -threads comma separated omp thread counts
+ * -r repetitions per point
+ * -d device sycl cpu or gpu
+ * -profile profile filename
+ * -o output filename for the raw sweep
+ */
+config ParseInputParams (int argc, char** argv)
+{
+  config conf;
+ int w_argc = argc - 1; // remaining arg count
+    while (w_argc > 0) {
+        char* w_arg = argv[argc - (w_argc--)]; // working arg
+        char* n_arg = (w_argc > 0) ? argv[argc - w_argc] : NULL; // next arg
+
+        if (strcmp(w_arg, "-min") == 0) {
+            w_argc--;
+            conf.min_size = std::max<size_t>(1, atol(n_arg));
+        }
+        else if (strcmp(w_arg, "-max") == 0) {
+            w_argc--;
+            conf.max_size = std::max<size_t>(1, atol(n_arg));
+        }
+        else if (strcmp(w_arg, "-xmax") == 0) {
+            w_argc--;
+            conf.crossover_max = std::max<size_t>(1, atol(n_arg));
+        }
+        else if (strcmp(w_arg, "-threads") == 0) {
+            w_argc--;
+            conf.threads = n_arg;
+        }
+        else if (strcmp(w_arg, "-r") == 0) {
+            w_argc--;
+            conf.repetitions = std::max(1, atoi(n_arg));
+        }
+        else if (strcmp(w_arg, "-d") == 0) {
+            w_argc--;
+            conf.device_str = n_arg;
+        }
+        else if (strcmp(w_arg, "-profile") == 0) {
+            w_argc--;
+            conf.profile_file = n_arg;
+        }
+        else if (strcmp(w_arg, "-o") == 0) {
+            w_argc--;
+            conf.filename = n_arg;
+        }
+}
+
+return conf;
+}
+
+//median wall time in fractional us of run() after a warmup run
+template<typename F>
+double median_us(int repetitions, F run)
+{
+  run(); //warmup RUN!
+  std::vector<double> t;
+  for (int r = 0; r < repetitions; r++)
+  {
+    auto t1 = std::chrono::steady_clock::now();
+    run();
+    auto t2 = std::chrono::steady_clock::now();
+    t.push_back(std::chrono::duration<double, std::micro>(t2 - t1).count());
+  }
+  std::sort(t.begin(), t.end());
+  return t[t.size() / 2];
+}
+
+//median wall time in us of one split. runtime_chrono_ms holds whole us,
+//too coarse for the small fit points
+double measure(coprocessing_runtime::device_entry &dev, coprocess_split split,
+               const int *a, const int *b, int *sum, int repetitions)
+{
+  return median_us(repetitions, [&]() { coprocess(dev, split, add_op<int>{}, sum, a, b); });
+}
+
+/**
+ * "OpenMP only" the way usm_add runs it (omp_add there), the loop the split
+ * predictor is applied to: a thread running a team whose members each open
+ * a nested parallel for over the cpu partition. with nested parallelism off
+ * every member walks the whole partition, so host_apply's single parallel
+ * for would fit a faster model than usm_add gets
+ */
+double measure_usm_add_omp(const int *a, const int *b, int *sum, size_t n, int omp_threads, int repetitions)
+{
+  int n_per_thread = std::max<size_t>(1, n / omp_threads);
+  return median_us(repetitions, [&]() {
+    std::thread tt([&]() {
+      long i;
+      #pragma omp parallel num_threads(omp_threads)
+      {
+        #pragma omp parallel for shared(a, b, sum) private(i) schedule(dynamic, n_per_thread)
+        for (i = 0; i < (long)n; i++) sum[i] = a[i] + b[i];
+      }
+    });
+    tt.join();
+  });
+}
+
+int main(int argc, char* argv[]) {
+
+  config conf = ParseInputParams (argc, argv);
+
+  std::vector<int> threads;
+  std::stringstream ss(conf.threads);
+  std::string item;
+  while (std::getline(ss, item, ',')) threads.push_back(std::max(1, atoi(item.c_str())));
+
+  std::ofstream myfile(conf.filename, std::ios_base::app);
+  if (myfile.tellp() == 0)
+    myfile << "benchmark;datasize;device;mode;omp_threads;time_ms_chrono" << std::endl;
+
+  try {
+    auto &dev = coprocessing_runtime::instance().get(conf.device_str);
+    device_profile profile;
+    profile.device_name = dev.q.get_device().get_info<info::device::name>();
+    std::cout << "Calibrating device: " << profile.device_name << "\n";
+
+    //one maximal allocation, every point uses a prefix of it
+    int *a = dev.pool().acquire<int>(conf.max_size);
+    int *b = dev.pool().acquire<int>(conf.max_size);
+    int *sum = dev.pool().acquire<int>(conf.max_size);
+    if (!a || !b || !sum) { std::cout << "Shared memory allocation failure.\n"; exit(-1); }
+    for (size_t i = 0; i < conf.max_size; i++) a[i] = b[i] = i;
+
+    std::vector<double> n_dev, t_dev;
+    std::map<int, std::vector<double>> n_cpu, t_cpu;
+    for (size_t size = conf.min_size; size <= conf.max_size; size *= 2)
+    {
+      double t = measure(dev, make_split(size, 0.f, 1), a, b, sum, conf.repetitions);
+      n_dev.push_back(size);
+      t_dev.push_back(t);
+      myfile << "calibrate;" << size << ";" << conf.device_str << ";Sycl only;0;" << t / 1000 << std::endl;
+
+      for (int th : threads)
+      {
+        t = measure_usm_add_omp(a, b, sum, size, th, conf.repetitions);
+        n_cpu[th].push_back(size);
+        t_cpu[th].push_back(t);
+        myfile << "calibrate;" << size << ";" << conf.device_str << ";OpenMP only;" << th << ";" << t / 1000 << std::endl;
+      }
+      std::cout << "size " << size << " done" << std::endl;
+    }
+
+    profile.sycl = linear_model::fit(n_dev, t_dev);
+    std::cout << "sycl: latency " << profile.sycl.latency_us << " us, "
+              << 1 / (profile.sycl.us_per_element * 1000) << " Gelem/s" << std::endl;
+    for (int th : threads)
+    {
+      profile.omp[th] = linear_model::fit(n_cpu[th], t_cpu[th]);
+      std::cout << "omp " << th << ": latency " << profile.omp[th].latency_us << " us, "
+                << 1 / (profile.omp[th].us_per_element * 1000) << " Gelem/s" << std::endl;
+    }
+
+    //crossover sweep: host fast path against the best offload route
+    int max_threads = *std::max_element(threads.begin(), threads.end());
+    std::vector<size_t> sizes;
+    std::vector<bool> host_wins;
+    for (size_t size = 1; size <= std::min(conf.crossover_max, conf.max_size); size *= 2)
+    {
+      coprocess_split fast = make_split(size, 0.f, 1);
+      fast.host_fast_path_below = size + 1;
+      double t_fast = measure(dev, fast, a, b, sum, conf.repetitions);
+
+      coprocess_split predicted = make_split(size, 0.f, max_threads);
+      predicted.start_index = profile.predict_start_index(size, max_threads);
+      double t_offload = std::min({measure(dev, make_split(size, 0.f, 1), a, b, sum, conf.repetitions),
+                                   measure(dev, make_split(size, 1.f, max_threads), a, b, sum, conf.repetitions),
+                                   measure(dev, predicted, a, b, sum, conf.repetitions)});
+      sizes.push_back(size);
+      host_wins.push_back(t_fast <= t_offload);
+      myfile << "calibrate;" << size << ";" << conf.device_str << ";host fast path;1;" << t_fast / 1000 << std::endl;
+      myfile << "calibrate;" << size << ";" << conf.device_str << ";best offload;" << max_threads << ";" << t_offload / 1000 << std::endl;
+    }
+    //first swept size above the largest one where the host loop still wins
+    profile.host_crossover = 0;
+    for (size_t k = 0; k < sizes.size(); k++)
+      if (host_wins[k]) profile.host_crossover = sizes[k] * 2;
+    std::cout << "host fast path below " << profile.host_crossover << " elements" << std::endl;
+
+    profile_store store(conf.profile_file);
+    store.put(profile);
+    std::cout << "profile written to " << conf.profile_file << std::endl;
+
+    dev.pool().release(a);
+    dev.pool().release(b);
+    dev.pool().release(sum);
+  } catch (exception const &e) {
+    std::cout << "An exception is caught during calibration.\n";
+    std::terminate();
+  }
+  return 0;
+}
@@ -0,0 +1,175 @@
+#ifndef CALIBRATION_HPP
+#define CALIBRATION_HPP
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+/**
+ * time_us(n) = latency_us + us_per_element * n, fitted by least squares
+ * over the calibration sweep
+ */
+struct linear_model
+{
+  double latency_us = 0;
+  double us_per_element = 0;
+
+  double time_us(double n) const { return latency_us + us_per_element * n; }
+
+  static linear_model fit(const std::vector<double> &n, const std::vector<double> &t)
+  {
+    linear_model m;
+    size_t k = n.size();
+    if (k == 0) return m;
+    double sx = 0, sy = 0, sxx = 0, sxy = 0;
+    for (size_t i = 0; i < k; i++)
+    {
+      sx += n[i];
+      sy += t[i];
+      sxx += n[i] * n[i];
+      sxy += n[i] * t[i];
+    }
+    double d = k * sxx - sx * sx;
+    if (k < 2 || d == 0)
+    {
+      m.us_per_element = sx > 0 ? sy / sx : 0;
+      return m;
+    }
+    m.us_per_element = (k * sxy - sx * sy) / d;
+    m.latency_us = (sy - m.us_per_element * sx) / k;
+    if (m.latency_us < 0) m.latency_us = 0;
+    if (m.us_per_element < 0) m.us_per_element = 0;
+    return m;
+  }
+};
+
+/**
+ * calibrated throughput of one SYCL device and of the OpenMP cpu path per
+ * thread count, as used by benchmark() to pick start_index without trials
+ */
+struct device_profile
+{
+  std::string device_name;
+  linear_model sycl;
+  std::map<int, linear_model> omp; // key omp_threads
+  //below this many elements the single thread host loop beats any offload
+  size_t host_crossover = 0;
+
+  //model for the closest calibrated thread count
+  const linear_model *omp_model(int threads) const
+  {
+    const linear_model *best = nullptr;
+    int best_dist = 0;
+    for (auto &m : omp)
+    {
+      int dist = std::abs(m.first - threads);
+      if (best == nullptr || dist < best_dist)
+      {
+        best = &m.second;
+        best_dist = dist;
+      }
+    }
+    return best;
+  }
+
+  /**
+   * start_index (first element on the device) that minimizes the predicted
+   * makespan max(t_omp(start), t_sycl(size - start)). compares the balanced
+   * split with cpu only and device only, since the fixed latencies can make
+   * one side alone faster for small sizes
+   */
+  size_t predict_start_index(size_t size, int threads) const
+  {
+    const linear_model *c = omp_model(threads);
+    if (c == nullptr) return size / 2;
+    const linear_model &d = sycl;
+    double n = size;
+
+    //balanced point where both sides finish at the same time
+    double x = n;
+    double rate = c->us_per_element + d.us_per_element;
+    if (rate > 0) x = (d.latency_us - c->latency_us + d.us_per_element * n) / rate;
+    if (x < 0) x = 0;
+    if (x > n) x = n;
+
+    double t_split = std::max(c->time_us(x), d.time_us(n - x));
+    double t_cpu = c->time_us(n);
+    double t_dev = d.time_us(n);
+    if (t_cpu <= t_split && t_cpu <= t_dev) return size;
+    if (t_dev <= t_split) return 0;
+    return (size_t)x;
+  }
+};
+
+/**
+ * profile file with one line per model:
+ * device_name;sycl;0;latency_us;us_per_element
+ * device_name;omp;threads;latency_us;us_per_element
+ * device_name;crossover;0;elements;0
+ */
+class profile_store
+{
+ public:
+  explicit profile_store(std::string filename) : filename(filename) { load(); }
+
+  bool find(const std::string &device_name, device_profile &p) const
+  {
+    auto it = profiles.find(device_name);
+    if (it == profiles.end()) return false;
+    p = it->second;
+    return true;
+  }
+
+  void put(const device_profile &p)
+  {
+    profiles[p.device_name] = p;
+    save();
+  }
+
+ private:
+  void load()
+  {
+    std::ifstream in(filename);
+    std::string line;
+    while (std::getline(in, line))
+    {
+      std::stringstream ss(line);
+      std::vector<std::string> f;
+      std::string field;
+      while (std::getline(ss, field, ';')) f.push_back(field);
+      if (f.size() != 5) continue;
+      device_profile &p = profiles[f[0]];
+      p.device_name = f[0];
+      linear_model m;
+      m.latency_us = std::stod(f[3]);
+      m.us_per_element = std::stod(f[4]);
+      if (f[1] == "sycl") p.sycl = m;
+      else if (f[1] == "crossover") p.host_crossover = std::stoul(f[3]);
+      else p.omp[std::stoi(f[2])] = m;
+    }
+  }
+
+  void save() const
+  {
+    std::ofstream out(filename, std::ios_base::trunc);
+    out.precision(12);
+    for (auto &p : profiles)
+    {
+      out << p.first << ";sycl;0;" << p.second.sycl.latency_us << ";" << p.second.sycl.us_per_element << std::endl;
+      for (auto &m : p.second.omp)
+        out << p.first << ";omp;" << m.first << ";" << m.second.latency_us << ";" << m.second.us_per_element << std::endl;
+      out << p.first << ";crossover;0;" << p.second.host_crossover << ";0" << std::endl;
+    }
+  }
+
+  std::string filename;
+  std::map<std::string, device_profile> profiles;
+};
+
+#endif // CALIBRATION_HPP
@@ -0,0 +1,123 @@
+#ifndef COLUMN_FILE_HPP
+#define COLUMN_FILE_HPP
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/**
+ * Raw binary column file, native endian int32 values without header, mapped
+ * read-only. the whole mapping is advised MADV_SEQUENTIAL and the file
+ * POSIX_FADV_SEQUENTIAL so the kernel reads ahead aggressively and drops
+ * pages behind the reader; will_need starts page-in of a range the reader
+ * gets to later (MADV_WILLNEED), so disk reads overlap with work on the
+ * current chunk.
+ */
+class column_file
+{
+ public:
+  explicit column_file(const std::string &path) : path(path)
+  {
+    fd = open(path.c_str(), O_RDONLY);
+    struct stat st;
+    if (fd < 0 || fstat(fd, &st) != 0)
+    {
+      std::cout << "column file: cannot open " << path << std::endl;
+      exit(-1);
+    }
+    file_bytes = st.st_size;
+    if (file_bytes == 0) return;
+    posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+    base = mmap(nullptr, file_bytes, PROT_READ, MAP_SHARED, fd, 0);
+    if (base == MAP_FAILED)
+    {
+      std::cout << "column file: mmap failed" << std::endl;
+      exit(-1);
+    }
+    madvise(base, file_bytes, MADV_SEQUENTIAL);
+  }
+
+  ~column_file()
+  {
+    if (base != nullptr && base != MAP_FAILED) munmap(base, file_bytes);
+    if (fd >= 0) close(fd);
+  }
+
+  column_file(const column_file &) = delete;
+  column_file &operator=(const column_file &) = delete;
+
+  const int32_t *data() const { return (const int32_t *)base; }
+  size_t elements() const { return file_bytes / sizeof(int32_t); }
+  size_t bytes() const { return file_bytes; }
+
+  //start reading [begin, end) elements ahead of use, clipped to the file
+  void will_need(size_t begin, size_t end) const
+  {
+    end = std::min(end, elements());
+    if (begin >= end) return;
+    size_t page = sysconf(_SC_PAGESIZE);
+    size_t from = begin * sizeof(int32_t) / page * page;
+    madvise((char *)base + from, end * sizeof(int32_t) - from, MADV_WILLNEED);
+  }
+
+  //fraction of the file's pages in the page cache, via mincore
+  double resident_fraction() const
+  {
+    if (file_bytes == 0) return 0;
+    size_t page = sysconf(_SC_PAGESIZE);
+    std::vector<unsigned char> vec((file_bytes + page - 1) / page);
+    if (mincore(base, file_bytes, vec.data()) != 0) return -1;
+    size_t resident = 0;
+    for (unsigned char v : vec) resident += v & 1;
+    return (double)resident / vec.size();
+  }
+
+  /**
+   * drop the file's clean pages from the page cache for a cold run. only
+   * pages no process has mapped can go, call without a live column_file.
+   * no root needed, check resident_fraction for the result
+   */
+  static void evict(const std::string &path)
+  {
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) return;
+    fdatasync(fd);
+    posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+    close(fd);
+  }
+
+  //write elements values i % 1024, the sum is known in closed form
+  static bool generate(const std::string &path, size_t elements)
+  {
+    FILE *f = fopen(path.c_str(), "wb");
+    if (f == nullptr) return false;
+    std::vector<int32_t> block(1 << 20);
+    for (size_t done = 0; done < elements;)
+    {
+      size_t n = std::min(block.size(), elements - done);
+      for (size_t i = 0; i < n; i++) block[i] = (done + i) % 1024;
+      if (fwrite(block.data(), sizeof(int32_t), n, f) != n)
+      {
+        fclose(f);
+        return false;
+      }
+      done += n;
+    }
+    return fclose(f) == 0;
+  }
+
+ private:
+  std::string path;
+  int fd = -1;
+  size_t file_bytes = 0;
+  void *base = nullptr;
+};
+
+#endif // COLUMN_FILE_HPP
@@ -6,6 +6,8 @@
 #include <omp.h>
 #include <thread>
 
+#include "validation.hpp"
+
 
 
 using namespace sycl;
@@ -22,6 +24,7 @@ struct config
  size_t mib=1024;
  bool usm=true;
  bool do_validation=true;
+ validation_mode validation=validation_mode::full;
  hardware hw=gpu;  //cpu alternative
  std::string device_str = "cpu";
  std::string filename = "add_gpu.csv";
@@ -62,7 +65,8 @@ static auto exception_handler = [](sycl::exception_list e_list) {
  * -k size in KiB
  * -m size in MiB
  * -d device sycl cpu or gpu
- * --nv no validation
+ * --nv no validation, same as -val none
+ * -val validation mode none, serial, full, sampled or checksum
  * -o output filename
  * -s share cpu factor 0..1
  * -omp openmp threads int
@@ -76,9 +80,14 @@ config ParseInputParams (int argc, char** argv)
         char* n_arg = (w_argc > 0) ? argv[argc - w_argc] : NULL; // next arg
 
         if (strcmp(w_arg, "--nv") == 0) {
-            w_argc--;
             conf.do_validation = false;
-        
+            conf.validation = validation_mode::none;
+        }
+
+        else if (strcmp(w_arg, "-val") == 0) {
+            w_argc--;
+            conf.validation = parse_validation_mode(n_arg);
+            conf.do_validation = conf.validation != validation_mode::none;
         }
 
         else if (strcmp(w_arg, "-k") == 0) {
@@ -292,11 +301,12 @@ void benchmark(config conf, int * a_in, int * b_in, int * c_in, size_t vectorsiz
     int *a = malloc_shared<int>(conf.vector_size, q);
     int *b = malloc_shared<int>(conf.vector_size, q);
 
-    int *sum_sequential = malloc_shared<int>(conf.vector_size, q);
+    //only the serial check needs a fourth full size array
+    int *sum_sequential = conf.validation == validation_mode::serial ? malloc_shared<int>(conf.vector_size, q) : nullptr;
     int *sum_parallel = malloc_shared<int>(conf.vector_size, q);
 
   //exit if allocation failed
-    if ((a == nullptr) || (b == nullptr) || (sum_sequential == nullptr) ||
+    if ((a == nullptr) || (b == nullptr) || (conf.validation == validation_mode::serial && sum_sequential == nullptr) ||
         (sum_parallel == nullptr)) {
       if (a != nullptr) free(a, q);
       if (b != nullptr) free(b, q);
@@ -363,7 +373,12 @@ std::thread tt(omp_add, a,b,sum_parallel,conf);
       
 
 
-   if(!validate(a,b,sum_sequential,sum_parallel, conf.vector_size))
+   bool valid = true;
+   if(conf.validation == validation_mode::serial)
+     valid = validate(a,b,sum_sequential,sum_parallel, conf.vector_size);
+   else
+     valid = validate_add(conf.validation, q, a, b, sum_parallel, conf.vector_size, conf.start_index, conf.omp_threads);
+   if(!valid)
    {
    // return -1 if validation failed
    exit(-1);
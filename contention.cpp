@@ -0,0 +1,375 @@
+#include <sycl/sycl.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <numeric>
+#include <cstring>
+#include <climits>
+#include <random>
+#include <sstream>
+#include <string>
+#include <fstream>
+#include <thread>
+#include <vector>
+#include <omp.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "runtime.hpp"
+#include "elementwise.hpp"
+#include "process_barrier.hpp"
+
+
+using namespace sycl;
+
+/**
+ * Several tenants sharing one node: N forked processes, each running its own
+ * co-processed VectorAdd loop on the same device and cpu cores. tenant k takes
+ * the k-th entry (cycling) of the size and mode lists.
+ * arrival closed:  next operation as soon as the previous one is done
+ * arrival poisson: open loop, exponential gaps at rate ops/s per tenant,
+ *                  latency counts from the scheduled arrival
+ * -stagger delays the first operation of tenant k by k * stagger ms.
+ * every tenant configuration is first run alone the same way, then all
+ * together after a process_barrier. reported per tenant and overall:
+ * throughput, latency percentiles, slowdown (shared/alone mean latency) and
+ * Jain's fairness index over the per-tenant progress 1 / slowdown. with
+ * closed arrivals that is the shared/alone throughput ratio; with poisson
+ * arrivals throughput follows the rate, only latency shows the interference.
+ * SYCL is only initialized in the forked tenants, never in the launcher.
+ */
+struct config
+{
+ int tenants =4;
+ int iterations =200;
+ std::string sizes = "1"; //MiB per operation
+ std::string modes = "coprocessing"; //sycl, omp or coprocessing
+ std::string arrival = "closed";
+ double rate =100; //ops/s per tenant for poisson
+ double stagger_ms =0;
+ int omp_threads =2;
+ float share_cpu =0.5f;
+ bool alone =true;
+ std::string device_str = "gpu";
+ std::string barrier_key = "contention_key";
+ std::string filename = "contention.csv";
+};
+
+/**
+ * -n tenants
+ * -i iterations per tenant
+ * -m comma separated sizes in MiB
+ * -modes comma separated sycl, omp, coprocessing
+ * -arrival closed or poisson
+ * -rate ops/s per tenant for poisson arrivals
+ * -stagger ms between the first operations of consecutive tenants
+ * -omp openmp threads per tenant
+ * -s share cpu factor 0..1 for coprocessing tenants
+ * --no-alone skip the alone runs, slowdown and fairness are then not reported
+ * -d device sycl cpu or gpu
+ * -key barrier key file
+ * -o output filename
+ */
+config ParseInputParams (int argc, char** argv)
+{
+  config conf;
+ int w_argc = argc - 1; // remaining arg count
+    while (w_argc > 0) {
+        char* w_arg = argv[argc - (w_argc--)]; // working arg
+        char* n_arg = (w_argc > 0) ? argv[argc - w_argc] : NULL; // next arg
+
+        if (strcmp(w_arg, "-n") == 0) {
+            w_argc--;
+            conf.tenants = std::max(1, atoi(n_arg));
+        }
+        else if (strcmp(w_arg, "-i") == 0) {
+            w_argc--;
+            conf.iterations = std::max(1, atoi(n_arg));
+        }
+        else if (strcmp(w_arg, "-m") == 0) {
+            w_argc--;
+            conf.sizes = n_arg;
+        }
+        else if (strcmp(w_arg, "-modes") == 0) {
+            w_argc--;
+            conf.modes = n_arg;
+        }
+        else if (strcmp(w_arg, "-arrival") == 0) {
+            w_argc--;
+            conf.arrival = n_arg;
+        }
+        else if (strcmp(w_arg, "-rate") == 0) {
+            w_argc--;
+            conf.rate = std::max(0.001, atof(n_arg));
+        }
+        else if (strcmp(w_arg, "-stagger") == 0) {
+            w_argc--;
+            conf.stagger_ms = std::max(0.0, atof(n_arg));
+        }
+        else if (strcmp(w_arg, "-omp") == 0) {
+            w_argc--;
+            conf.omp_threads = std::max(1, atoi(n_arg));
+        }
+        else if (strcmp(w_arg, "-s") == 0) {
+            w_argc--;
+            conf.share_cpu = atof(n_arg);
+        }
+        else if (strcmp(w_arg, "--no-alone") == 0) {
+            conf.alone = false;
+        }
+        else if (strcmp(w_arg, "-d") == 0) {
+            w_argc--;
+            conf.device_str = n_arg;
+        }
+        else if (strcmp(w_arg, "-key") == 0) {
+            w_argc--;
+            conf.barrier_key = n_arg;
+        }
+        else if (strcmp(w_arg, "-o") == 0) {
+            w_argc--;
+            conf.filename = n_arg;
+        }
+}
+
+return conf;
+}
+
+struct tenant_spec
+{
+  size_t vector_size = 0;
+  std::string mode;
+  float share_cpu = 0;
+};
+
+/**
+ * results of one tenant in memory shared with the launcher, followed by
+ * iterations latencies in us
+ */
+struct tenant_slot
+{
+  int64_t start_ns = 0;
+  int64_t end_ns = 0;
+  int done = 0;
+  int failed = 0;
+  double latency_us[1];
+};
+
+std::vector<std::string> split_list(const std::string &list)
+{
+  std::vector<std::string> items;
+  std::stringstream ss(list);
+  std::string item;
+  while (std::getline(ss, item, ',')) items.push_back(item);
+  if (items.empty()) items.push_back(list);
+  return items;
+}
+
+tenant_spec make_spec(config conf, int k)
+{
+  std::vector<std::string> sizes = split_list(conf.sizes);
+  std::vector<std::string> modes = split_list(conf.modes);
+  tenant_spec t;
+  t.vector_size = std::max<size_t>(1, (size_t)(atof(sizes[k % sizes.size()].c_str()) * 256 * 1024));
+  t.mode = modes[k % modes.size()];
+  if (t.mode != "sycl" && t.mode != "omp" && t.mode != "coprocessing")
+  {
+    std::cout << "unknown mode " << t.mode << ", use sycl, omp or coprocessing" << std::endl;
+    exit(-1);
+  }
+  t.share_cpu = t.mode == "sycl" ? 0.f : t.mode == "omp" ? 1.f : conf.share_cpu;
+  return t;
+}
+
+int64_t now_ns()
+{
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+//body of one forked tenant, writes into its slot and exits
+void tenant(config conf, int k, int participants, tenant_slot *slot)
+{
+  tenant_spec t = make_spec(conf, k);
+  size_t n = t.vector_size;
+  try {
+    auto &dev = coprocessing_runtime::instance().get(conf.device_str);
+    int *a = dev.pool().acquire<int>(n);
+    int *b = dev.pool().acquire<int>(n);
+    int *sum = dev.pool().acquire<int>(n);
+    if (!a || !b || !sum) { std::cout << "Shared memory allocation failure.\n"; exit(-1); }
+    for (size_t i = 0; i < n; i++) a[i] = b[i] = i;
+
+    coprocess_split split = make_split(n, t.share_cpu, conf.omp_threads);
+    //warmup RUN!
+    coprocess(dev, split, add_op<int>{}, sum, (const int *)a, (const int *)b);
+
+    process_barrier barrier(conf.barrier_key, participants);
+    barrier.wait();
+
+    std::mt19937_64 rng(1234 + k);
+    std::exponential_distribution<double> gap(conf.rate);
+    auto start = std::chrono::steady_clock::now() +
+                 std::chrono::microseconds((int64_t)(k * conf.stagger_ms * 1000));
+    std::this_thread::sleep_until(start);
+    slot->start_ns = now_ns();
+
+    auto next = start;
+    for (int it = 0; it < conf.iterations; it++)
+    {
+      auto issue = std::chrono::steady_clock::now();
+      if (conf.arrival == "poisson")
+      {
+        next += std::chrono::nanoseconds((int64_t)(gap(rng) * 1e9));
+        std::this_thread::sleep_until(next);
+        issue = next;
+      }
+      coprocess(dev, split, add_op<int>{}, sum, (const int *)a, (const int *)b);
+      slot->latency_us[it] = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - issue).count();
+      slot->done = it + 1;
+    }
+    slot->end_ns = now_ns();
+
+    for (size_t i = 0; i < n; i += std::max<size_t>(1, n / 4096))
+      if (sum[i] != (int)(2 * i)) { slot->failed = 1; break; }
+  } catch (exception const &e) {
+    std::cout << "An exception is caught in tenant " << k << ".\n";
+    slot->failed = 1;
+  }
+}
+
+/**
+ * fork one process per tenant in ids, all meeting at one barrier, and wait
+ * for them. slots live in an anonymous shared mapping made before the fork
+ */
+void run_group(config conf, const std::vector<int> &ids, char *slots, size_t slot_bytes)
+{
+  std::vector<pid_t> pids;
+  for (int k : ids)
+  {
+    pid_t pid = fork();
+    if (pid == 0)
+    {
+      tenant(conf, k, ids.size(), (tenant_slot *)(slots + k * slot_bytes));
+      _exit(0);
+    }
+    pids.push_back(pid);
+  }
+  for (pid_t pid : pids) waitpid(pid, nullptr, 0);
+}
+
+double percentile(std::vector<double> v, double p)
+{
+  std::sort(v.begin(), v.end());
+  return v[std::min(v.size() - 1, (size_t)(p * v.size()))];
+}
+
+double mean(const std::vector<double> &v)
+{
+  double s = 0;
+  for (double x : v) s += x;
+  return v.empty() ? 0 : s / v.size();
+}
+
+struct tenant_stats
+{
+  std::vector<double> latency;
+  double ops_per_s = 0;
+};
+
+tenant_stats stats(const tenant_slot *slot)
+{
+  tenant_stats s;
+  s.latency.assign(slot->latency_us, slot->latency_us + slot->done);
+  double seconds = (slot->end_ns - slot->start_ns) / 1e9;
+  s.ops_per_s = seconds > 0 ? slot->done / seconds : 0;
+  return s;
+}
+
+// Jain's fairness index (sum x)^2 / (n sum x^2), 1 if all x are equal
+double jain(const std::vector<double> &x)
+{
+  double s = 0, s2 = 0;
+  for (double v : x) { s += v; s2 += v * v; }
+  return s2 > 0 ? s * s / (x.size() * s2) : 0;
+}
+
+int main(int argc, char* argv[]) {
+
+  config conf = ParseInputParams (argc, argv);
+  int n = conf.tenants;
+  //reject bad -m/-modes lists here, not in every forked tenant
+  for (int k = 0; k < n; k++) make_spec(conf, k);
+
+  size_t slot_bytes = (sizeof(tenant_slot) + conf.iterations * sizeof(double) + 63) / 64 * 64;
+  char *alone_slots = (char *)mmap(nullptr, n * slot_bytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+  char *shared_slots = (char *)mmap(nullptr, n * slot_bytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+  if (alone_slots == MAP_FAILED || shared_slots == MAP_FAILED) { std::cout << "mmap failed\n"; exit(-1); }
+
+  //each configuration alone, one after the other
+  if (conf.alone)
+    for (int k = 0; k < n; k++) run_group(conf, {k}, alone_slots, slot_bytes);
+
+  std::vector<int> all;
+  for (int k = 0; k < n; k++) all.push_back(k);
+  run_group(conf, all, shared_slots, slot_bytes);
+
+  std::ofstream myfile(conf.filename, std::ios_base::app);
+  if (myfile.tellp() == 0)
+    myfile << "benchmark;tenants;tenant;datasize;mode;arrival;iterations;ops_per_s;latency_ms_mean;latency_ms_p50;latency_ms_p99;alone_ms_mean;slowdown;jain" << std::endl;
+
+  std::vector<double> progress; //1 / slowdown per tenant
+  std::vector<std::string> rows;
+  double total_ops = 0;
+  int64_t first = INT64_MAX, last = 0;
+  for (int k = 0; k < n; k++)
+  {
+    const tenant_slot *slot = (const tenant_slot *)(shared_slots + k * slot_bytes);
+    if (slot->failed || slot->done == 0) { std::cout << "tenant " << k << " failed" << std::endl; exit(-1); }
+    tenant_spec t = make_spec(conf, k);
+    tenant_stats s = stats(slot);
+    total_ops += slot->done;
+    first = std::min(first, slot->start_ns);
+    last = std::max(last, slot->end_ns);
+
+    double alone_mean = 0, slowdown = 0;
+    if (conf.alone)
+    {
+      tenant_stats a = stats((const tenant_slot *)(alone_slots + k * slot_bytes));
+      alone_mean = mean(a.latency);
+      slowdown = alone_mean > 0 ? mean(s.latency) / alone_mean : 0;
+      if (slowdown > 0) progress.push_back(1 / slowdown);
+    }
+
+    std::cout << "tenant " << k << " " << t.mode << " " << t.vector_size << ": " << s.ops_per_s << " ops/s, p50 "
+              << percentile(s.latency, 0.5) / 1000 << " ms p99 " << percentile(s.latency, 0.99) / 1000
+              << " ms, slowdown " << slowdown << std::endl;
+    std::stringstream row;
+    row << "contention" << ";" << n
+    << ";" << k
+    << ";" << t.vector_size
+    << ";" << t.mode
+    << ";" << conf.arrival
+    << ";" << slot->done
+    << ";" << s.ops_per_s
+    << ";" << mean(s.latency) / 1000
+    << ";" << percentile(s.latency, 0.5) / 1000
+    << ";" << percentile(s.latency, 0.99) / 1000
+    << ";" << alone_mean / 1000
+    << ";" << slowdown;
+    rows.push_back(row.str());
+  }
+
+  double fairness = progress.size() == (size_t)n ? jain(progress) : 0;
+  double aggregate = last > first ? total_ops / ((last - first) / 1e9) : 0;
+  std::cout << "aggregate " << aggregate << " ops/s, Jain's fairness index " << fairness << std::endl;
+  for (auto &r : rows) myfile << r << ";" << fairness << std::endl;
+  myfile << "contention" << ";" << n << ";all;-;" << conf.modes << ";" << conf.arrival << ";" << total_ops
+  << ";" << aggregate << ";-;-;-;-;" << (progress.empty() ? 0 : n / std::accumulate(progress.begin(), progress.end(), 0.0))
+  << ";" << fairness << std::endl;
+
+  munmap(alone_slots, n * slot_bytes);
+  munmap(shared_slots, n * slot_bytes);
+  return 0;
+}
@@ -0,0 +1,281 @@
+#ifndef CORO_HPP
+#define CORO_HPP
+
+#include <sycl/sycl.hpp>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <coroutine>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "runtime.hpp"
+#include "elementwise.hpp"
+
+using namespace sycl;
+
+/**
+ * C++20 coroutine front end for co-processed operators (needs -std=c++20).
+ * co_await coprocess_add(rt, dev, split, a, b, sum) starts the device
+ * partition and queues the cpu partition to a small thread pool, then
+ * suspends. a reactor thread polls the SYCL events and cpu completion flags
+ * and resumes the coroutine on the pool once both parts are done, so no
+ * thread ever blocks in e.wait() or join().
+ */
+
+//lazily started coroutine returning T, resumes its awaiter when done
+template<typename T>
+class task
+{
+ public:
+  struct promise_type
+  {
+    T value{};
+    std::coroutine_handle<> continuation;
+    std::exception_ptr error;
+
+    task get_return_object() { return task(std::coroutine_handle<promise_type>::from_promise(*this)); }
+    std::suspend_always initial_suspend() noexcept { return {}; }
+
+    struct final_awaiter
+    {
+      bool await_ready() noexcept { return false; }
+      std::coroutine_handle<> await_suspend(std::coroutine_handle<promise_type> h) noexcept
+      {
+        auto c = h.promise().continuation;
+        return c ? c : std::noop_coroutine();
+      }
+      void await_resume() noexcept {}
+    };
+    final_awaiter final_suspend() noexcept { return {}; }
+
+    void return_value(T v) { value = std::move(v); }
+    void unhandled_exception() { error = std::current_exception(); }
+  };
+
+  task(task &&o) noexcept : h(std::exchange(o.h, {})) {}
+  task(const task &) = delete;
+  ~task() { if (h) h.destroy(); }
+
+  bool await_ready() const noexcept { return false; }
+  std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept
+  {
+    h.promise().continuation = awaiting;
+    return h;
+  }
+  T await_resume()
+  {
+    if (h.promise().error) std::rethrow_exception(h.promise().error);
+    return std::move(h.promise().value);
+  }
+
+ private:
+  explicit task(std::coroutine_handle<promise_type> h) : h(h) {}
+  std::coroutine_handle<promise_type> h;
+};
+
+//eagerly started coroutine that owns itself, for the top level of a client
+struct detached
+{
+  struct promise_type
+  {
+    detached get_return_object() { return {}; }
+    std::suspend_never initial_suspend() noexcept { return {}; }
+    std::suspend_never final_suspend() noexcept { return {}; }
+    void return_void() {}
+    void unhandled_exception() { std::terminate(); }
+  };
+};
+
+//fixed number of OS threads running queued jobs
+class thread_pool
+{
+ public:
+  explicit thread_pool(int threads)
+  {
+    for (int t = 0; t < threads; t++) workers.emplace_back([this]() { loop(); });
+  }
+  ~thread_pool()
+  {
+    {
+      std::lock_guard<std::mutex> lock(m);
+      stop = true;
+    }
+    cv.notify_all();
+    for (auto &w : workers) w.join();
+  }
+
+  void post(std::function<void()> job)
+  {
+    {
+      std::lock_guard<std::mutex> lock(m);
+      jobs.push_back(std::move(job));
+    }
+    cv.notify_one();
+  }
+
+ private:
+  void loop()
+  {
+    for (;;)
+    {
+      std::function<void()> job;
+      {
+        std::unique_lock<std::mutex> lock(m);
+        cv.wait(lock, [this]() { return stop || !jobs.empty(); });
+        if (jobs.empty()) return;
+        job = std::move(jobs.front());
+        jobs.pop_front();
+      }
+      job();
+    }
+  }
+
+  std::mutex m;
+  std::condition_variable cv;
+  std::deque<std::function<void()>> jobs;
+  bool stop = false;
+  std::vector<std::thread> workers;
+};
+
+/**
+ * completion reactor: one thread that polls registered operations and hands
+ * the suspended coroutine of every finished one back to the pool
+ */
+class reactor
+{
+ public:
+  struct pending
+  {
+    event e;
+    bool device_part = false;
+    std::atomic<bool> cpu_done{true};
+    std::coroutine_handle<> h;
+  };
+
+  explicit reactor(int threads) : pool(threads), poller([this]() { loop(); }) {}
+  ~reactor()
+  {
+    {
+      std::lock_guard<std::mutex> lock(m);
+      stop = true;
+    }
+    cv.notify_one();
+    poller.join();
+  }
+
+  void watch(pending *p)
+  {
+    {
+      std::lock_guard<std::mutex> lock(m);
+      incoming.push_back(p);
+    }
+    cv.notify_one();
+  }
+
+  thread_pool pool;
+
+ private:
+  static bool done(pending *p)
+  {
+    return p->cpu_done &&
+           (!p->device_part ||
+            p->e.get_info<info::event::command_execution_status>() == info::event_command_status::complete);
+  }
+
+  void loop()
+  {
+    std::vector<pending *> active;
+    for (;;)
+    {
+      {
+        std::unique_lock<std::mutex> lock(m);
+        if (active.empty()) cv.wait(lock, [this]() { return stop || !incoming.empty(); });
+        if (stop && active.empty() && incoming.empty()) return;
+        active.insert(active.end(), incoming.begin(), incoming.end());
+        incoming.clear();
+      }
+
+      bool progress = false;
+      for (size_t k = 0; k < active.size();)
+      {
+        if (done(active[k]))
+        {
+          auto h = active[k]->h;
+          pool.post([h]() { h.resume(); });
+          active[k] = active.back();
+          active.pop_back();
+          progress = true;
+        }
+        else k++;
+      }
+      if (!progress) std::this_thread::yield();
+    }
+  }
+
+  std::mutex m;
+  std::condition_variable cv;
+  std::vector<pending *> incoming;
+  bool stop = false;
+  std::thread poller;
+};
+
+/**
+ * awaitable co-processed VectorAdd. the cpu partition runs as one SIMD loop
+ * on a pool thread, the pool threads are the host parallelism here.
+ * co_await returns the latency from submit to resume in us
+ */
+class coprocess_add
+{
+ public:
+  coprocess_add(reactor &rt, coprocessing_runtime::device_entry &dev, const coprocess_split &split,
+                const int *a, const int *b, int *sum)
+      : rt(rt), dev(dev), split(split), a(a), b(b), sum(sum) {}
+
+  bool await_ready() const noexcept { return false; }
+
+  void await_suspend(std::coroutine_handle<> h)
+  {
+    size_t n = split.vector_size;
+    size_t start = std::min(split.start_index, n);
+    state.h = h;
+    submitted = std::chrono::steady_clock::now();
+
+    state.device_part = start < n;
+    if (state.device_part) state.e = device_apply(dev.q, add_op<int>{}, sum, start, n, {}, a, b);
+    if (start > 0)
+    {
+      state.cpu_done = false;
+      auto f = at_index(add_op<int>{}, a, b);
+      int *out = sum;
+      reactor::pending *p = &state;
+      rt.pool.post([f, out, start, p]() {
+        host_simd_apply_indexed(f, out, 0, start);
+        p->cpu_done = true;
+      });
+    }
+    rt.watch(&state);
+  }
+
+  double await_resume()
+  {
+    return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - submitted).count();
+  }
+
+ private:
+  reactor &rt;
+  coprocessing_runtime::device_entry &dev;
+  coprocess_split split;
+  const int *a;
+  const int *b;
+  int *sum;
+  reactor::pending state;
+  std::chrono::steady_clock::time_point submitted;
+};
+
+#endif // CORO_HPP
@@ -0,0 +1,215 @@
+#include <sycl/sycl.hpp>
+#include <algorithm>
+#include <atomic>
+#include <iostream>
+#include <string>
+#include <fstream>
+#include <thread>
+#include <vector>
+
+#include "runtime.hpp"
+#include "elementwise.hpp"
+#include "coro.hpp"
+
+
+using namespace sycl;
+
+/**
+ * Thousands of concurrent small co-processed VectorAdds on a few OS threads.
+ * async:    one coroutine per client, co_await coprocess_add, resumed by the
+ *           reactor on a pool of threads OS threads
+ * blocking: the same clients served by threads OS threads that wait in
+ *           e.wait() for every operation
+ * build with -std=c++20
+ */
+struct config
+{
+ size_t vector_size =1024; //number of elements per operation (4 byte int)
+ int clients =4096;
+ int ops_per_client =16;
+ int threads =4;
+ float share_cpu =0.5f;
+ std::string device_str = "gpu";
+ std::string filename = "coro.csv";
+};
+
+/**
+ * -n elements per operation
+ * -c concurrent clients
+ * -ops operations per client
+ * -threads OS threads
+ * -s share cpu factor 0..1
+ * -d device sycl cpu or gpu
+ * -o output filename
+ */
+config ParseInputParams (int argc, char** argv)
+{
+  config conf;
+ int w_argc = argc - 1; // remaining arg count
+    while (w_argc > 0) {
+        char* w_arg = argv[argc - (w_argc--)]; // working arg
+        char* n_arg = (w_argc > 0) ? argv[argc - w_argc] : NULL; // next arg
+
+        if (strcmp(w_arg, "-n") == 0) {
+            w_argc--;
+            conf.vector_size = std::max<size_t>(1, atol(n_arg));
+        }
+        else if (strcmp(w_arg, "-c") == 0) {
+            w_argc--;
+            conf.clients = std::max(1, atoi(n_arg));
+        }
+        else if (strcmp(w_arg, "-ops") == 0) {
+            w_argc--;
+            conf.ops_per_client = std::max(1, atoi(n_arg));
+        }
+        else if (strcmp(w_arg, "-threads") == 0) {
+            w_argc--;
+            conf.threads = std::max(1, atoi(n_arg));
+        }
+        else if (strcmp(w_arg, "-s") == 0) {
+            w_argc--;
+            conf.share_cpu = atof(n_arg);
+        }
+        else if (strcmp(w_arg, "-d") == 0) {
+            w_argc--;
+            conf.device_str = n_arg;
+        }
+        else if (strcmp(w_arg, "-o") == 0) {
+            w_argc--;
+            conf.filename = n_arg;
+        }
+}
+
+return conf;
+}
+
+struct client_data
+{
+  int *a = nullptr;
+  int *b = nullptr;
+  int *sum = nullptr;
+  std::vector<double> latency;
+};
+
+task<double> timed_add(reactor &rt, coprocessing_runtime::device_entry &dev, coprocess_split split, client_data &c)
+{
+  co_return co_await coprocess_add(rt, dev, split, c.a, c.b, c.sum);
+}
+
+detached client(reactor &rt, coprocessing_runtime::device_entry &dev, coprocess_split split,
+                client_data &c, int ops, std::atomic<int> &finished)
+{
+  for (int k = 0; k < ops; k++) c.latency.push_back(co_await timed_add(rt, dev, split, c));
+  finished++;
+}
+
+//blocking reference: thread t serves clients t, t + threads, ... one operation at a time
+void blocking_worker(coprocessing_runtime::device_entry &dev, coprocess_split split,
+                     std::vector<client_data> &clients, int t, int threads, int ops)
+{
+  size_t n = split.vector_size;
+  size_t start = std::min(split.start_index, n);
+  for (int k = 0; k < ops; k++)
+    for (size_t c = t; c < clients.size(); c += threads)
+    {
+      client_data &cd = clients[c];
+      auto t1 = std::chrono::steady_clock::now();
+      event e;
+      if (start < n) e = device_apply(dev.q, add_op<int>{}, cd.sum, start, n, {}, (const int *)cd.a, (const int *)cd.b);
+      host_simd_apply_indexed(at_index(add_op<int>{}, (const int *)cd.a, (const int *)cd.b), cd.sum, 0, start);
+      if (start < n) e.wait();
+      cd.latency.push_back(std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - t1).count());
+    }
+}
+
+double percentile(std::vector<double> v, double p)
+{
+  std::sort(v.begin(), v.end());
+  return v[std::min(v.size() - 1, (size_t)(p * v.size()))];
+}
+
+void report(std::ofstream &myfile, config conf, const std::string &mode, std::vector<client_data> &clients, double seconds)
+{
+  std::vector<double> all;
+  for (auto &c : clients)
+  {
+    all.insert(all.end(), c.latency.begin(), c.latency.end());
+    c.latency.clear();
+    for (size_t i = 0; i < conf.vector_size; i++)
+      if (c.sum[i] != (int)(2 * i)) { std::cout << "Vector add failed at index " << i << "\n"; exit(-1); }
+  }
+  double ops = all.size() / seconds;
+  std::cout << mode << ": " << ops << " ops/s, latency p50 " << percentile(all, 0.5) << " us p99 "
+            << percentile(all, 0.99) << " us" << std::endl;
+  myfile << "coro_add" << ";" << conf.vector_size
+  << ";" << conf.device_str
+  << ";" << mode
+  << ";" << conf.clients
+  << ";" << conf.threads
+  << ";" << ops
+  << ";" << percentile(all, 0.5) / 1000
+  << ";" << percentile(all, 0.99) / 1000
+  << std::endl;
+}
+
+int main(int argc, char* argv[]) {
+
+  config conf = ParseInputParams (argc, argv);
+  size_t n = conf.vector_size;
+  coprocess_split split = make_split(n, conf.share_cpu, 1);
+
+  std::ofstream myfile(conf.filename, std::ios_base::app);
+  if (myfile.tellp() == 0)
+    myfile << "benchmark;datasize;device;mode;clients;os_threads;ops_per_s;latency_ms_p50;latency_ms_p99" << std::endl;
+
+  try {
+    auto &dev = coprocessing_runtime::instance().get(conf.device_str);
+    std::cout << "Running on device: "
+             << dev.q.get_device().get_info<info::device::name>() << "\n";
+
+    std::vector<client_data> clients(conf.clients);
+    for (auto &c : clients)
+    {
+      c.a = dev.pool().acquire<int>(n);
+      c.b = dev.pool().acquire<int>(n);
+      c.sum = dev.pool().acquire<int>(n);
+      if (!c.a || !c.b || !c.sum) { std::cout << "Shared memory allocation failure.\n"; exit(-1); }
+      for (size_t i = 0; i < n; i++) c.a[i] = c.b[i] = i;
+      c.latency.reserve(conf.ops_per_client);
+    }
+
+    //warmup RUN!
+    device_apply(dev.q, add_op<int>{}, clients[0].sum, 0, n, {}, (const int *)clients[0].a, (const int *)clients[0].b).wait();
+
+    {
+      reactor rt(conf.threads);
+      std::atomic<int> finished{0};
+      auto t1 = std::chrono::steady_clock::now();
+      for (auto &c : clients) client(rt, dev, split, c, conf.ops_per_client, finished);
+      while (finished < conf.clients) std::this_thread::sleep_for(std::chrono::microseconds(100));
+      auto t2 = std::chrono::steady_clock::now();
+      report(myfile, conf, "async", clients, std::chrono::duration<double>(t2 - t1).count());
+    }
+
+    {
+      std::vector<std::thread> threads;
+      auto t1 = std::chrono::steady_clock::now();
+      for (int t = 0; t < conf.threads; t++)
+        threads.emplace_back(blocking_worker, std::ref(dev), split, std::ref(clients), t, conf.threads, conf.ops_per_client);
+      for (auto &t : threads) t.join();
+      auto t2 = std::chrono::steady_clock::now();
+      report(myfile, conf, "blocking", clients, std::chrono::duration<double>(t2 - t1).count());
+    }
+
+    for (auto &c : clients)
+    {
+      dev.pool().release(c.a);
+      dev.pool().release(c.b);
+      dev.pool().release(c.sum);
+    }
+  } catch (exception const &e) {
+    std::cout << "An exception is caught while adding two vectors.\n";
+    std::terminate();
+  }
+  return 0;
+}
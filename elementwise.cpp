@@ -0,0 +1,219 @@
+#include <sycl/sycl.hpp>
+#include <algorithm>
+#include <iostream>
+#include <string>
+#include <fstream>
+#include <omp.h>
+
+#include "runtime.hpp"
+#include "elementwise.hpp"
+#include "calibration.hpp"
+
+
+using namespace sycl;
+
+//CHANGE parameter here
+struct config
+{
+ size_t vector_size =1024*256; //define size as number of elements
+ int omp_threads =8;
+ size_t mib=1;
+ bool do_validation=true;
+ std::string device_str = "gpu";
+ std::string filename = "elementwise.csv";
+ std::string op = "add";
+ std::string type = "int32";
+ float share_cpu =0.5f;
+ int repetitions =1;
+ std::string fast_path = "0"; //elements, or auto for the calibrated crossover
+ std::string profile_file = "coprocessing_profile.csv";
+};
+
+/**
+ * -k size in KiB
+ * -m size in MiB
+ * -d device sycl cpu or gpu
+ * --nv no validation
+ * -o output filename
+ * -s share cpu factor 0..1
+ * -omp openmp threads int
+ * -op copy, scale, add, triad, fma or custom
+ * -t int32, int64, float, double or half
+ * -r repetitions after warmup
+ * -fast host fast path below this many elements, auto for the calibrated crossover
+ * -profile calibration profile filename written by calibrate
+ */
+config ParseInputParams (int argc, char** argv)
+{
+  config conf;
+ int w_argc = argc - 1; // remaining arg count
+    while (w_argc > 0) {
+        char* w_arg = argv[argc - (w_argc--)]; // working arg
+        char* n_arg = (w_argc > 0) ? argv[argc - w_argc] : NULL; // next arg
+
+        if (strcmp(w_arg, "--nv") == 0) {
+            conf.do_validation = false;
+        }
+        else if (strcmp(w_arg, "-k") == 0) {
+            w_argc--;
+            conf.vector_size = 256 * std::max<size_t>(1, atol(n_arg));
+        }
+        else if (strcmp(w_arg, "-m") == 0) {
+            w_argc--;
+            conf.mib = std::max<size_t>(1, atol(n_arg));
+            conf.vector_size = 256 * 1024 * conf.mib;
+        }
+        else if (strcmp(w_arg, "-omp") == 0) {
+            w_argc--;
+            conf.omp_threads = std::max(1, atoi(n_arg));
+        }
+        else if (strcmp(w_arg, "-d") == 0) {
+            w_argc--;
+            conf.device_str = n_arg;
+        }
+        else if (strcmp(w_arg, "-o") == 0) {
+            w_argc--;
+            conf.filename = n_arg;
+        }
+        else if (strcmp(w_arg, "-s") == 0) {
+            w_argc--;
+            conf.share_cpu = atof(n_arg);
+        }
+        else if (strcmp(w_arg, "-op") == 0) {
+            w_argc--;
+            conf.op = n_arg;
+        }
+        else if (strcmp(w_arg, "-t") == 0) {
+            w_argc--;
+            conf.type = n_arg;
+        }
+        else if (strcmp(w_arg, "-fast") == 0) {
+            w_argc--;
+            conf.fast_path = n_arg;
+        }
+        else if (strcmp(w_arg, "-profile") == 0) {
+            w_argc--;
+            conf.profile_file = n_arg;
+        }
+        else if (strcmp(w_arg, "-r") == 0) {
+            w_argc--;
+            conf.repetitions = std::max(1, atoi(n_arg));
+        }
+}
+
+return conf;
+}
+
+//example of a user defined expression, no change to the framework needed
+template<typename T>
+struct custom_op
+{
+  static constexpr const char *name = "custom";
+  T operator()(T a, T b, T c) const { return (a - b) * c + a; }
+};
+
+void print_to_file (config conf, coprocess_times timer)
+{
+  std::ofstream myfile(conf.filename, std::ios_base::app);
+  if (myfile.tellp() == 0)
+    myfile << "benchmark;datasize;device;type;time_ms_event;time_ms_chrono;omp_threads;cpu_share;mode" << std::endl;
+
+  myfile << conf.op << ";" << conf.vector_size
+  << ";" << conf.device_str
+  << ";" << conf.type
+  << ";" << timer.runtime_event_ms / 1000000 << ";" << timer.runtime_chrono_ms / 1000
+  << ";" << conf.omp_threads
+  << ";" << conf.share_cpu
+  << ";" << timer.processing_mode
+  << std::endl;
+}
+
+/**
+ * warmup, timed repetitions and validation of one operator. in holds the
+ * input arrays, only the first arity of them are passed to op
+ */
+template<typename Op, typename T, typename... In>
+void run_op(config conf, coprocessing_runtime::device_entry &dev, Op op, T *out, const In *...in)
+{
+  coprocess_split split = make_split(conf.vector_size, conf.share_cpu, conf.omp_threads);
+  if (conf.fast_path == "auto")
+  {
+    device_profile profile;
+    if (profile_store(conf.profile_file).find(dev.q.get_device().get_info<info::device::name>(), profile))
+      split.host_fast_path_below = profile.host_crossover;
+  }
+  else split.host_fast_path_below = atol(conf.fast_path.c_str());
+
+  //warmup RUN!
+  coprocess(dev, split, op, out, in...);
+  for (int r = 0; r < conf.repetitions; r++)
+  {
+    coprocess_times timer = coprocess(dev, split, op, out, in...);
+    std::cout << conf.op << " " << conf.type << " " << timer.processing_mode << " chrono "
+              << timer.runtime_chrono_ms / 1000 << " ms" << std::endl;
+    print_to_file(conf, timer);
+  }
+
+  if (conf.do_validation && !validate_op(op, out, conf.vector_size, in...))
+  {
+    // return -1 if validation failed
+    exit(-1);
+  }
+}
+
+template<typename T>
+void benchmark(config conf)
+{
+  auto &dev = coprocessing_runtime::instance().get(conf.device_str);
+  usm_pool &pool = dev.pool();
+  std::cout << "Running on device: "
+           << dev.q.get_device().get_info<info::device::name>() << "\n";
+
+  T *a = pool.acquire<T>(conf.vector_size);
+  T *b = pool.acquire<T>(conf.vector_size);
+  T *c = pool.acquire<T>(conf.vector_size);
+  T *out = pool.acquire<T>(conf.vector_size);
+  if ((a == nullptr) || (b == nullptr) || (c == nullptr) || (out == nullptr)) {
+    std::cout << "Shared memory allocation failure.\n";
+    exit(-1);
+  }
+
+  //small values so fma and triad stay in range for int32 and half
+  for (size_t i = 0; i < conf.vector_size; i++)
+  {
+    a[i] = T(i % 1000);
+    b[i] = T(i % 7 + 1);
+    c[i] = T(i % 13);
+  }
+
+  if (conf.op == "copy") run_op(conf, dev, copy_op<T>{}, out, a);
+  else if (conf.op == "scale") run_op(conf, dev, scale_op<T>{T(3)}, out, a);
+  else if (conf.op == "add") run_op(conf, dev, add_op<T>{}, out, a, b);
+  else if (conf.op == "triad") run_op(conf, dev, triad_op<T>{T(3)}, out, a, b);
+  else if (conf.op == "fma") run_op(conf, dev, fma_op<T>{}, out, a, b, c);
+  else if (conf.op == "custom") run_op(conf, dev, custom_op<T>{}, out, a, b, c);
+  else std::cout << "unknown op " << conf.op << std::endl;
+
+  pool.release(a);
+  pool.release(b);
+  pool.release(c);
+  pool.release(out);
+}
+
+int main(int argc, char* argv[]) {
+
+  config conf = ParseInputParams (argc, argv);
+
+  try {
+    if (conf.type == "int32") benchmark<int32_t>(conf);
+    else if (conf.type == "int64") benchmark<int64_t>(conf);
+    else if (conf.type == "float") benchmark<float>(conf);
+    else if (conf.type == "double") benchmark<double>(conf);
+    else if (conf.type == "half") benchmark<half>(conf);
+    else std::cout << "unknown type " << conf.type << std::endl;
+  } catch (exception const &e) {
+    std::cout << "An exception is caught while running the elementwise operator.\n";
+    std::terminate();
+  }
+  return 0;
+}
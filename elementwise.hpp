@@ -0,0 +1,250 @@
+#ifndef ELEMENTWISE_HPP
+#define ELEMENTWISE_HPP
+
+#include <sycl/sycl.hpp>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <vector>
+#include <omp.h>
+
+#include "runtime.hpp"
+
+using namespace sycl;
+
+/**
+ * Elementwise operators. An operator is any functor callable with one value
+ * per input array, the arity is the number of input pointers passed to the
+ * apply functions below. The same functor object is used for the device
+ * kernel, the OpenMP cpu partition and the serial validation reference, so
+ * it has to be trivially copyable and must not call host-only code.
+ */
+template<typename T>
+struct copy_op
+{
+  static constexpr const char *name = "copy";
+  T operator()(T a) const { return a; }
+};
+
+template<typename T>
+struct scale_op
+{
+  static constexpr const char *name = "scale";
+  T s;
+  T operator()(T a) const { return s * a; }
+};
+
+template<typename T>
+struct add_op
+{
+  static constexpr const char *name = "add";
+  T operator()(T a, T b) const { return a + b; }
+};
+
+// STREAM triad: a + s * b
+template<typename T>
+struct triad_op
+{
+  static constexpr const char *name = "triad";
+  T s;
+  T operator()(T a, T b) const { return a + s * b; }
+};
+
+template<typename T>
+struct sub_op
+{
+  static constexpr const char *name = "sub";
+  T operator()(T a, T b) const { return a - b; }
+};
+
+template<typename T>
+struct mul_op
+{
+  static constexpr const char *name = "mul";
+  T operator()(T a, T b) const { return a * b; }
+};
+
+template<typename T>
+struct fma_op
+{
+  static constexpr const char *name = "fma";
+  T operator()(T a, T b, T c) const { return a * b + c; }
+};
+
+/**
+ * split of one co-processed operation, same rule as benchmark():
+ * cpu calculates [0, start_index), device [start_index, vector_size)
+ */
+struct coprocess_split
+{
+  size_t vector_size = 0;
+  size_t start_index = 0;
+  int omp_threads = 8;
+  //sizes below this skip device and OpenMP team, 0 disables the fast path
+  size_t host_fast_path_below = 0;
+};
+
+struct coprocess_times
+{
+  double runtime_chrono_ms = 0.f;
+  double runtime_event_ms = 0.f;
+  std::string processing_mode = "";
+};
+
+inline coprocess_split make_split(size_t vector_size, float share_cpu, int omp_threads)
+{
+  coprocess_split s;
+  s.vector_size = vector_size;
+  s.omp_threads = omp_threads;
+  s.start_index = (vector_size - 1) * share_cpu;
+  if (share_cpu >= 0.99f) s.start_index = vector_size;
+  return s;
+}
+
+//device part: out[i] = f(i) for i in [begin, end)
+template<typename F, typename T>
+event device_apply_indexed(queue &q, F f, T *out, size_t begin, size_t end,
+                           const std::vector<event> &deps = {})
+{
+  return q.submit([&](handler &h) {
+    h.depends_on(deps);
+    h.parallel_for(range<1>{end - begin}, [=](id<1> idx) {
+      size_t i = begin + idx;
+      out[i] = f(i);
+    });
+  });
+}
+
+//cpu part: same loop over [begin, end) with omp_threads OpenMP threads
+template<typename F, typename T>
+void host_apply_indexed(int omp_threads, F f, T *out, size_t begin, size_t end)
+{
+  #pragma omp parallel for num_threads(omp_threads) schedule(static)
+  for (size_t i = begin; i < end; i++) out[i] = f(i);
+}
+
+//single thread SIMD loop, no thread or kernel launch for tiny sizes
+template<typename F, typename T>
+void host_simd_apply_indexed(F f, T *out, size_t begin, size_t end)
+{
+  #pragma omp simd
+  for (size_t i = begin; i < end; i++) out[i] = f(i);
+}
+
+//op applied to the i-th element of every input
+template<typename Op, typename... In>
+auto at_index(Op op, const In *...in)
+{
+  return [=](size_t i) { return op(in[i]...); };
+}
+
+template<typename Op, typename T, typename... In>
+event device_apply(queue &q, Op op, T *out, size_t begin, size_t end,
+                   const std::vector<event> &deps, const In *...in)
+{
+  return device_apply_indexed(q, at_index(op, in...), out, begin, end, deps);
+}
+
+template<typename Op, typename T, typename... In>
+void host_apply(int omp_threads, Op op, T *out, size_t begin, size_t end, const In *...in)
+{
+  host_apply_indexed(omp_threads, at_index(op, in...), out, begin, end);
+}
+
+//widen for comparison and printing, half has no direct double conversion
+template<typename T>
+double as_double(T v)
+{
+  if constexpr (std::is_same<T, half>::value) return static_cast<float>(v);
+  else return static_cast<double>(v);
+}
+
+/**
+ * Validate result by recomputing op serially on the host.
+ * integral types are compared exactly, floating types with a relative
+ * tolerance since device and host may contract to fma differently
+ */
+template<typename Op, typename T, typename... In>
+bool validate_op(Op op, const T *result, size_t size, const In *...in)
+{
+  for (size_t i = 0; i < size; i++)
+  {
+    T expected = op(in[i]...);
+    bool ok;
+    if constexpr (std::is_integral<T>::value) ok = result[i] == expected;
+    else
+    {
+      double e = as_double(expected), r = as_double(result[i]);
+      double tol = sizeof(T) <= 2 ? 1e-2 : (sizeof(T) == 4 ? 1e-5 : 1e-12);
+      ok = std::fabs(e - r) <= tol * std::fmax(1.0, std::fabs(e));
+    }
+    if (!ok)
+    {
+      std::cout << "Elementwise op failed at index " << i << "\n";
+      std::cout << " device |  host " << as_double(result[i]) << " " << as_double(expected) << std::endl;
+      return false;
+    }
+  }
+  return true;
+}
+
+/**
+ * Co-process out[i] = f(i) over the split: the cpu partition runs in an
+ * OpenMP team on a separate thread while the device partition runs on
+ * dev.q. sizes below host_fast_path_below run on the calling thread only.
+ * fills wall time, device kernel time and the processing mode
+ */
+template<typename F, typename T>
+coprocess_times coprocess_indexed(coprocessing_runtime::device_entry &dev, const coprocess_split &split,
+                                  F f, T *out)
+{
+  coprocess_times timer;
+  size_t n = split.vector_size;
+  size_t start = split.start_index < n ? split.start_index : n;
+
+  auto total1 = std::chrono::steady_clock::now();
+  if (n < split.host_fast_path_below)
+  {
+    timer.processing_mode = "host fast path";
+    host_simd_apply_indexed(f, out, 0, n);
+  }
+  else if (start == 0)
+  {
+    timer.processing_mode = "Sycl only";
+    event e = device_apply_indexed(dev.q, f, out, 0, n);
+    e.wait();
+    timer.runtime_event_ms = e.template get_profiling_info<info::event_profiling::command_end>() -
+                             e.template get_profiling_info<info::event_profiling::command_start>();
+  }
+  else if (start >= n)
+  {
+    timer.processing_mode = "OpenMP only";
+    host_apply_indexed(split.omp_threads, f, out, 0, n);
+  }
+  else
+  {
+    timer.processing_mode = "coprocessing";
+    std::thread tt([&]() { host_apply_indexed(split.omp_threads, f, out, 0, start); });
+    event e = device_apply_indexed(dev.q, f, out, start, n);
+    e.wait();
+    tt.join();
+    timer.runtime_event_ms = e.template get_profiling_info<info::event_profiling::command_end>() -
+                             e.template get_profiling_info<info::event_profiling::command_start>();
+  }
+  auto total2 = std::chrono::steady_clock::now();
+  timer.runtime_chrono_ms = std::chrono::duration_cast<std::chrono::microseconds>(total2 - total1).count();
+  return timer;
+}
+
+//co-process out[i] = op(in[i]...)
+template<typename Op, typename T, typename... In>
+coprocess_times coprocess(coprocessing_runtime::device_entry &dev, const coprocess_split &split,
+                          Op op, T *out, const In *...in)
+{
+  return coprocess_indexed(dev, split, at_index(op, in...), out);
+}
+
+#endif // ELEMENTWISE_HPP
@@ -0,0 +1,101 @@
+#ifndef EXPRESSION_HPP
+#define EXPRESSION_HPP
+
+#include <sycl/sycl.hpp>
+#include <type_traits>
+
+#include "runtime.hpp"
+#include "elementwise.hpp"
+
+using namespace sycl;
+
+/**
+ * Lazy elementwise expressions. Building (col(a) + col(b)) * col(c) - col(d)
+ * only records the tree; evaluate() turns the whole tree into one indexed
+ * functor, so the device runs one parallel_for and the cpu partition one
+ * loop, reading every input once and writing the output once instead of
+ * one pass with a temporary per operator.
+ * Nodes only hold raw USM pointers and scalars so they can be copied into
+ * the kernel.
+ */
+
+//leaf: element i of a USM array
+template<typename T>
+struct column_expr
+{
+  using value_type = T;
+  static constexpr int ops = 0;
+  static constexpr int columns = 1;
+  const T *p;
+  T operator()(size_t i) const { return p[i]; }
+};
+
+//leaf: the same value for every i
+template<typename T>
+struct scalar_expr
+{
+  using value_type = T;
+  static constexpr int ops = 0;
+  static constexpr int columns = 0;
+  T v;
+  T operator()(size_t) const { return v; }
+};
+
+//inner node: op applied to both children at i, op is one of the elementwise.hpp functors
+template<typename L, typename R, typename Op>
+struct binary_expr
+{
+  using value_type = typename L::value_type;
+  static constexpr int ops = L::ops + R::ops + 1;
+  static constexpr int columns = L::columns + R::columns;
+  L l;
+  R r;
+  Op op;
+  value_type operator()(size_t i) const { return op(l(i), r(i)); }
+};
+
+template<typename E> struct is_expr : std::false_type {};
+template<typename T> struct is_expr<column_expr<T>> : std::true_type {};
+template<typename T> struct is_expr<scalar_expr<T>> : std::true_type {};
+template<typename L, typename R, typename Op> struct is_expr<binary_expr<L, R, Op>> : std::true_type {};
+
+template<typename T>
+column_expr<T> col(const T *p) { return column_expr<T>{p}; }
+
+template<typename T>
+scalar_expr<T> scalar(T v) { return scalar_expr<T>{v}; }
+
+#define EXPRESSION_OPERATOR(sym, op_type)                                                  \
+  template<typename L, typename R,                                                         \
+           typename = std::enable_if_t<is_expr<L>::value && is_expr<R>::value>>            \
+  binary_expr<L, R, op_type<typename L::value_type>> operator sym(const L &l, const R &r)  \
+  {                                                                                        \
+    return {l, r, op_type<typename L::value_type>{}};                                      \
+  }
+
+EXPRESSION_OPERATOR(+, add_op)
+EXPRESSION_OPERATOR(-, sub_op)
+EXPRESSION_OPERATOR(*, mul_op)
+
+#undef EXPRESSION_OPERATOR
+
+/**
+ * co-process out[i] = e(i) with the usual split, one device kernel and one
+ * OpenMP loop for the whole tree
+ */
+template<typename E, typename T>
+coprocess_times evaluate(coprocessing_runtime::device_entry &dev, const coprocess_split &split,
+                         T *out, const E &e)
+{
+  static_assert(is_expr<E>::value, "evaluate needs an expression built from col()/scalar()");
+  return coprocess_indexed(dev, split, e, out);
+}
+
+//bytes the fused evaluation reads and writes for n elements
+template<typename E>
+size_t fused_bytes(size_t n)
+{
+  return (E::columns + 1) * n * sizeof(typename E::value_type);
+}
+
+#endif // EXPRESSION_HPP
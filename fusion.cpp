@@ -0,0 +1,237 @@
+#include <sycl/sycl.hpp>
+#include <algorithm>
+#include <iostream>
+#include <string>
+#include <fstream>
+#include <omp.h>
+
+#include "runtime.hpp"
+#include "elementwise.hpp"
+#include "expression.hpp"
+
+
+using namespace sycl;
+
+/**
+ * Fused versus unfused evaluation of the chain
+ *   ((((x0 + x1) * x2 - x3) + x4) * x5) - x6
+ * cut after 2 to 6 operators. unfused runs one co-processed pass per
+ * operator through temporaries, fused evaluates the expression tree in one
+ * pass. both use the same split.
+ */
+struct config
+{
+ size_t vector_size =1024*256*64; //number of elements (4 byte int)
+ int omp_threads =8;
+ float share_cpu =0.5f;
+ int repetitions =5;
+ bool do_validation=true;
+ std::string device_str = "gpu";
+ std::string filename = "fusion.csv";
+};
+
+/**
+ * -k size in KiB
+ * -m size in MiB
+ * -d device sycl cpu or gpu
+ * --nv no validation
+ * -o output filename
+ * -s share cpu factor 0..1
+ * -omp openmp threads int
+ * -r repetitions
+ */
+config ParseInputParams (int argc, char** argv)
+{
+  config conf;
+ int w_argc = argc - 1; // remaining arg count
+    while (w_argc > 0) {
+        char* w_arg = argv[argc - (w_argc--)]; // working arg
+        char* n_arg = (w_argc > 0) ? argv[argc - w_argc] : NULL; // next arg
+
+        if (strcmp(w_arg, "--nv") == 0) {
+            conf.do_validation = false;
+        }
+        else if (strcmp(w_arg, "-k") == 0) {
+            w_argc--;
+            conf.vector_size = 256 * std::max<size_t>(1, atol(n_arg));
+        }
+        else if (strcmp(w_arg, "-m") == 0) {
+            w_argc--;
+            conf.vector_size = 256 * 1024 * std::max<size_t>(1, atol(n_arg));
+        }
+        else if (strcmp(w_arg, "-omp") == 0) {
+            w_argc--;
+            conf.omp_threads = std::max(1, atoi(n_arg));
+        }
+        else if (strcmp(w_arg, "-d") == 0) {
+            w_argc--;
+            conf.device_str = n_arg;
+        }
+        else if (strcmp(w_arg, "-o") == 0) {
+            w_argc--;
+            conf.filename = n_arg;
+        }
+        else if (strcmp(w_arg, "-s") == 0) {
+            w_argc--;
+            conf.share_cpu = atof(n_arg);
+        }
+        else if (strcmp(w_arg, "-r") == 0) {
+            w_argc--;
+            conf.repetitions = std::max(1, atoi(n_arg));
+        }
+}
+
+return conf;
+}
+
+constexpr int max_ops = 6;
+constexpr char chain_ops[max_ops] = {'+', '*', '-', '+', '*', '-'};
+
+//expression of the first K operators of the chain
+template<int K>
+auto chain(int *const *x)
+{
+  if constexpr (K == 1) return col<int>(x[0]) + col<int>(x[1]);
+  else if constexpr (chain_ops[K - 1] == '+') return chain<K - 1>(x) + col<int>(x[K]);
+  else if constexpr (chain_ops[K - 1] == '*') return chain<K - 1>(x) * col<int>(x[K]);
+  else return chain<K - 1>(x) - col<int>(x[K]);
+}
+
+//one pass per operator, ping-pong between two temporaries, last pass into out
+coprocess_times unfused(coprocessing_runtime::device_entry &dev, const coprocess_split &split,
+                        int ops, int *const *x, int *tmp0, int *tmp1, int *out)
+{
+  coprocess_times total;
+  const int *lhs = x[0];
+  for (int k = 0; k < ops; k++)
+  {
+    int *dst = (k == ops - 1) ? out : (k % 2 == 0 ? tmp0 : tmp1);
+    coprocess_times t;
+    if (chain_ops[k] == '+') t = coprocess(dev, split, add_op<int>{}, dst, lhs, (const int *)x[k + 1]);
+    else if (chain_ops[k] == '*') t = coprocess(dev, split, mul_op<int>{}, dst, lhs, (const int *)x[k + 1]);
+    else t = coprocess(dev, split, sub_op<int>{}, dst, lhs, (const int *)x[k + 1]);
+    total.runtime_chrono_ms += t.runtime_chrono_ms;
+    total.runtime_event_ms += t.runtime_event_ms;
+    total.processing_mode = t.processing_mode;
+    lhs = dst;
+  }
+  return total;
+}
+
+template<int K>
+coprocess_times fused(coprocessing_runtime::device_entry &dev, const coprocess_split &split,
+                      int *const *x, int *out)
+{
+  return evaluate(dev, split, out, chain<K>(x));
+}
+
+coprocess_times fused(coprocessing_runtime::device_entry &dev, const coprocess_split &split,
+                      int ops, int *const *x, int *out)
+{
+  switch (ops)
+  {
+    case 2: return fused<2>(dev, split, x, out);
+    case 3: return fused<3>(dev, split, x, out);
+    case 4: return fused<4>(dev, split, x, out);
+    case 5: return fused<5>(dev, split, x, out);
+    default: return fused<6>(dev, split, x, out);
+  }
+}
+
+//memory traffic of the fused evaluation, from the expression type of the chain
+size_t fused_chain_bytes(int ops, size_t n)
+{
+  switch (ops)
+  {
+    case 2: return fused_bytes<decltype(chain<2>(nullptr))>(n);
+    case 3: return fused_bytes<decltype(chain<3>(nullptr))>(n);
+    case 4: return fused_bytes<decltype(chain<4>(nullptr))>(n);
+    case 5: return fused_bytes<decltype(chain<5>(nullptr))>(n);
+    default: return fused_bytes<decltype(chain<6>(nullptr))>(n);
+  }
+}
+
+void print_row(std::ofstream &myfile, config conf, int ops, std::string variant,
+               coprocess_times timer, size_t bytes)
+{
+  double gbs = bytes / (timer.runtime_chrono_ms * 1000);
+  std::cout << ops << " ops " << variant << " " << timer.runtime_chrono_ms / 1000 << " ms "
+            << gbs << " GB/s effective, moved " << bytes / (1024 * 1024) << " MiB" << std::endl;
+  myfile << "fusion" << ";" << conf.vector_size
+  << ";" << conf.device_str
+  << ";" << ops
+  << ";" << variant
+  << ";" << timer.runtime_event_ms / 1000000 << ";" << timer.runtime_chrono_ms / 1000
+  << ";" << bytes
+  << ";" << conf.omp_threads
+  << ";" << conf.share_cpu
+  << ";" << timer.processing_mode
+  << std::endl;
+}
+
+int main(int argc, char* argv[]) {
+
+  config conf = ParseInputParams (argc, argv);
+
+  std::ofstream myfile(conf.filename, std::ios_base::app);
+  if (myfile.tellp() == 0)
+    myfile << "benchmark;datasize;device;ops;variant;time_ms_event;time_ms_chrono;bytes;omp_threads;cpu_share;mode" << std::endl;
+
+  try {
+    auto &dev = coprocessing_runtime::instance().get(conf.device_str);
+    usm_pool &pool = dev.pool();
+    std::cout << "Running on device: "
+             << dev.q.get_device().get_info<info::device::name>() << "\n";
+
+    size_t n = conf.vector_size;
+    int *x[max_ops + 1];
+    for (int j = 0; j <= max_ops; j++)
+    {
+      x[j] = pool.acquire<int>(n);
+      if (x[j] == nullptr) { std::cout << "Shared memory allocation failure.\n"; exit(-1); }
+      //small values, the chain has two multiplications
+      for (size_t i = 0; i < n; i++) x[j][i] = (i + j) % 10;
+    }
+    int *tmp0 = pool.acquire<int>(n);
+    int *tmp1 = pool.acquire<int>(n);
+    int *out_unfused = pool.acquire<int>(n);
+    int *out_fused = pool.acquire<int>(n);
+    if (!tmp0 || !tmp1 || !out_unfused || !out_fused) { std::cout << "Shared memory allocation failure.\n"; exit(-1); }
+
+    coprocess_split split = make_split(n, conf.share_cpu, conf.omp_threads);
+
+    for (int ops = 2; ops <= max_ops; ops++)
+    {
+      //each operator reads two arrays and writes one, fused reads every input once
+      size_t bytes_unfused = 3 * ops * n * sizeof(int);
+      size_t bytes_fused = fused_chain_bytes(ops, n);
+
+      //warmup RUN!
+      unfused(dev, split, ops, x, tmp0, tmp1, out_unfused);
+      fused(dev, split, ops, x, out_fused);
+      for (int r = 0; r < conf.repetitions; r++)
+      {
+        print_row(myfile, conf, ops, "unfused", unfused(dev, split, ops, x, tmp0, tmp1, out_unfused), bytes_unfused);
+        print_row(myfile, conf, ops, "fused", fused(dev, split, ops, x, out_fused), bytes_fused);
+      }
+
+      if (conf.do_validation && !validate_op(copy_op<int>{}, out_fused, n, (const int *)out_unfused))
+      {
+        // return -1 if validation failed
+        exit(-1);
+      }
+      std::cout << ops << " ops: fused saves " << (bytes_unfused - bytes_fused) / (1024 * 1024)
+                << " MiB of memory traffic per evaluation" << std::endl;
+    }
+
+    for (int j = 0; j <= max_ops; j++) pool.release(x[j]);
+    pool.release(tmp0);
+    pool.release(tmp1);
+    pool.release(out_unfused);
+    pool.release(out_fused);
+  } catch (exception const &e) {
+    std::cout << "An exception is caught while evaluating the expressions.\n";
+    std::terminate();
+  }
+  return 0;
+}
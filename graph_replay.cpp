@@ -0,0 +1,184 @@
+#include <sycl/sycl.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "runtime.hpp"
+#include "replay.hpp"
+
+
+using namespace sycl;
+
+/**
+ * Launch overhead of a repeated copy -> add -> aggregate sequence:
+ * c = a, sum = c + b, total = sum of sum, on USM from coprocessing_runtime.
+ * eager:  three q.submit per iteration, chained by events
+ * replay: recorded once with kernel_sequence (graph or command list) and
+ *         replayed per iteration
+ * for each size the median wall time per iteration of both is reported next
+ * to the kernel time of the three steps from the eager profiling events, so
+ * the ratio wall / kernel shows how much of an iteration is submission.
+ */
+struct config
+{
+ size_t min_size =256; //number of elements (4 byte int)
+ size_t max_size =1024*1024*16;
+ int iterations =100;
+ bool prefer_graph =true;
+ std::string device_str = "gpu";
+ std::string filename = "graph_replay.csv";
+};
+
+/**
+ * -min smallest vector size in elements
+ * -max largest vector size in elements
+ * -i iterations per size and mode
+ * --no-graph replay from the in-order command list even if graphs are supported
+ * -d device sycl cpu or gpu
+ * -o output filename
+ */
+config ParseInputParams (int argc, char** argv)
+{
+  config conf;
+ int w_argc = argc - 1; // remaining arg count
+    while (w_argc > 0) {
+        char* w_arg = argv[argc - (w_argc--)]; // working arg
+        char* n_arg = (w_argc > 0) ? argv[argc - w_argc] : NULL; // next arg
+
+        if (strcmp(w_arg, "-min") == 0) {
+            w_argc--;
+            conf.min_size = std::max<size_t>(1, atol(n_arg));
+        }
+        else if (strcmp(w_arg, "-max") == 0) {
+            w_argc--;
+            conf.max_size = std::max<size_t>(1, atol(n_arg));
+        }
+        else if (strcmp(w_arg, "-i") == 0) {
+            w_argc--;
+            conf.iterations = std::max(1, atoi(n_arg));
+        }
+        else if (strcmp(w_arg, "--no-graph") == 0) {
+            conf.prefer_graph = false;
+        }
+        else if (strcmp(w_arg, "-d") == 0) {
+            w_argc--;
+            conf.device_str = n_arg;
+        }
+        else if (strcmp(w_arg, "-o") == 0) {
+            w_argc--;
+            conf.filename = n_arg;
+        }
+}
+
+return conf;
+}
+
+void InitializeArray(int *a, size_t size) {
+  for (size_t i = 0; i < size; i++) a[i] = i;
+}
+
+double median(std::vector<double> v)
+{
+  std::sort(v.begin(), v.end());
+  return v[v.size() / 2];
+}
+
+double event_ns(event &e)
+{
+  return e.get_profiling_info<info::event_profiling::command_end>() -
+         e.get_profiling_info<info::event_profiling::command_start>();
+}
+
+int main(int argc, char* argv[]) {
+
+  config conf = ParseInputParams (argc, argv);
+
+  std::ofstream myfile(conf.filename, std::ios_base::app);
+  if (myfile.tellp() == 0)
+    myfile << "benchmark;datasize;device;mode;iterations;time_us_wall;time_us_kernel;wall_per_kernel" << std::endl;
+
+  try {
+    auto &dev = coprocessing_runtime::instance().get(conf.device_str);
+    std::cout << "Running on device: " << dev.q.get_device().get_info<info::device::name>() << "\n";
+
+    for (size_t size = conf.min_size; size <= conf.max_size; size *= 2)
+    {
+      int *a = dev.pool().acquire<int>(size);
+      int *b = dev.pool().acquire<int>(size);
+      int *c = dev.pool().acquire<int>(size);
+      int *sum = dev.pool().acquire<int>(size);
+      int64_t *total = dev.pool().acquire<int64_t>(1);
+      if (!a || !b || !c || !sum || !total) {
+        std::cout << "Shared memory allocation failure.\n";
+        exit(-1);
+      }
+      InitializeArray(a, size);
+      InitializeArray(b, size);
+
+      kernel_sequence seq(dev.q);
+      seq.add([=](handler &h) { h.parallel_for(range<1>{size}, [=](id<1> i) { c[i] = a[i]; }); });
+      seq.add([=](handler &h) { h.parallel_for(range<1>{size}, [=](id<1> i) { sum[i] = c[i] + b[i]; }); });
+      //the reduction combines with the value in total, cleared in the sequence
+      seq.add([=](handler &h) { h.single_task([=]() { *total = 0; }); });
+      seq.add([=](handler &h) {
+        h.parallel_for(range<1>{size}, reduction(total, plus<int64_t>()), [=](id<1> i, auto &acc) { acc += sum[i]; });
+      });
+      int64_t expected = (int64_t)size * (size - 1);
+
+      //warmup RUN!
+      seq.eager();
+      std::string kind = seq.record(conf.prefer_graph);
+      seq.replay();
+
+      std::vector<double> eager_wall, replay_wall, kernel;
+      for (int it = 0; it < conf.iterations; it++)
+      {
+        auto t1 = std::chrono::steady_clock::now();
+        std::vector<event> events = seq.eager();
+        auto t2 = std::chrono::steady_clock::now();
+        eager_wall.push_back(std::chrono::duration<double, std::micro>(t2 - t1).count());
+        double k = 0;
+        for (auto &e : events) k += event_ns(e);
+        kernel.push_back(k / 1000);
+      }
+      bool valid = *total == expected;
+      for (int it = 0; it < conf.iterations; it++)
+      {
+        *total = -1;
+        auto t1 = std::chrono::steady_clock::now();
+        seq.replay();
+        auto t2 = std::chrono::steady_clock::now();
+        replay_wall.push_back(std::chrono::duration<double, std::micro>(t2 - t1).count());
+      }
+      valid = valid && *total == expected && sum[size - 1] == (int)(2 * (size - 1));
+      if (!valid) {
+        std::cout << "copy -> add -> aggregate failed for size " << size << std::endl;
+        exit(-1);
+      }
+
+      double k = median(kernel);
+      double e = median(eager_wall);
+      double r = median(replay_wall);
+      std::cout << size << ": kernel " << k << " us, eager " << e << " us, replay (" << kind << ") " << r
+                << " us per iteration" << std::endl;
+      myfile << "graph_replay" << ";" << size << ";" << conf.device_str << ";" << "eager" << ";" << conf.iterations
+             << ";" << e << ";" << k << ";" << (k > 0 ? e / k : 0) << std::endl;
+      myfile << "graph_replay" << ";" << size << ";" << conf.device_str << ";" << "replay " << kind << ";"
+             << conf.iterations << ";" << r << ";" << k << ";" << (k > 0 ? r / k : 0) << std::endl;
+
+      dev.pool().release(a);
+      dev.pool().release(b);
+      dev.pool().release(c);
+      dev.pool().release(sum);
+      dev.pool().release(total);
+    }
+  } catch (exception const &e) {
+    std::cout << "An exception is caught while replaying kernels.\n";
+    std::terminate();
+  }
+  return 0;
+}
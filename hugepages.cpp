@@ -0,0 +1,234 @@
+#include <sycl/sycl.hpp>
+#include <algorithm>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <fstream>
+#include <chrono>
+#include <vector>
+#include <omp.h>
+
+#include "runtime.hpp"
+#include "hugepages.hpp"
+
+
+using namespace sycl;
+
+/**
+ * 4 KiB versus 2 MiB pages for the host side of the co-processed VectorAdd:
+ * first touch init and the OpenMP add of the cpu partition, which is where
+ * multi-GiB vectors spend their time in dTLB misses.
+ * host:   a, b and sum from host_pages_alloc with the page policy
+ * shared: a, b and sum from malloc_shared, advised with the page policy
+ * every phase reports time, bandwidth, dTLB load misses and how many bytes
+ * actually ended up on huge pages
+ */
+struct config
+{
+ size_t vector_size =1024*1024*256; //number of elements (4 byte int)
+ int omp_threads =8;
+ int repetitions =5;
+ std::string policies = "4k,thp,hugetlb";
+ std::string alloc = "both";
+ std::string device_str = "gpu";
+ std::string filename = "hugepages.csv";
+};
+
+/**
+ * -k size in KiB
+ * -m size in MiB
+ * -omp openmp threads int
+ * -r repetitions of the add
+ * -pages comma separated page policies system, 4k, thp, hugetlb
+ * -alloc host, shared or both
+ * -d device sycl cpu or gpu, owner of the shared allocations
+ * -o output filename
+ */
+config ParseInputParams (int argc, char** argv)
+{
+  config conf;
+ int w_argc = argc - 1; // remaining arg count
+    while (w_argc > 0) {
+        char* w_arg = argv[argc - (w_argc--)]; // working arg
+        char* n_arg = (w_argc > 0) ? argv[argc - w_argc] : NULL; // next arg
+
+        if (strcmp(w_arg, "-k") == 0) {
+            w_argc--;
+            conf.vector_size = 256 * std::max<size_t>(1, atol(n_arg));
+        }
+        else if (strcmp(w_arg, "-m") == 0) {
+            w_argc--;
+            conf.vector_size = 256 * 1024 * std::max<size_t>(1, atol(n_arg));
+        }
+        else if (strcmp(w_arg, "-omp") == 0) {
+            w_argc--;
+            conf.omp_threads = std::max(1, atoi(n_arg));
+        }
+        else if (strcmp(w_arg, "-r") == 0) {
+            w_argc--;
+            conf.repetitions = std::max(1, atoi(n_arg));
+        }
+        else if (strcmp(w_arg, "-pages") == 0) {
+            w_argc--;
+            conf.policies = n_arg;
+        }
+        else if (strcmp(w_arg, "-alloc") == 0) {
+            w_argc--;
+            conf.alloc = n_arg;
+        }
+        else if (strcmp(w_arg, "-d") == 0) {
+            w_argc--;
+            conf.device_str = n_arg;
+        }
+        else if (strcmp(w_arg, "-o") == 0) {
+            w_argc--;
+            conf.filename = n_arg;
+        }
+}
+
+return conf;
+}
+
+struct phase_result
+{
+  double us = 0;
+  long long dtlb_misses = -1;
+};
+
+//parallel first touch, static schedule so every thread touches the pages it adds later
+phase_result init(dtlb_counter &tlb, config conf, int *a, int *b, int *sum)
+{
+  phase_result r;
+  size_t n = conf.vector_size;
+  tlb.start();
+  auto t1 = std::chrono::steady_clock::now();
+  #pragma omp parallel for num_threads(conf.omp_threads) schedule(static)
+  for (size_t i = 0; i < n; i++) { a[i] = i; b[i] = i; sum[i] = 0; }
+  auto t2 = std::chrono::steady_clock::now();
+  r.dtlb_misses = tlb.stop();
+  r.us = std::chrono::duration<double, std::micro>(t2 - t1).count();
+  return r;
+}
+
+phase_result add(dtlb_counter &tlb, config conf, const int *a, const int *b, int *sum)
+{
+  phase_result r;
+  size_t n = conf.vector_size;
+  tlb.start();
+  auto t1 = std::chrono::steady_clock::now();
+  #pragma omp parallel for num_threads(conf.omp_threads) schedule(static)
+  for (size_t i = 0; i < n; i++) sum[i] = a[i] + b[i];
+  auto t2 = std::chrono::steady_clock::now();
+  r.dtlb_misses = tlb.stop();
+  r.us = std::chrono::duration<double, std::micro>(t2 - t1).count();
+  return r;
+}
+
+void report(std::ofstream &myfile, config conf, const std::string &alloc, const std::string &pages,
+            const std::string &phase, phase_result r, size_t huge_bytes)
+{
+  //three arrays touched in both phases
+  double gbs = 3.0 * conf.vector_size * sizeof(int) / (r.us * 1000);
+  std::cout << alloc << " " << pages << " " << phase << ": " << r.us / 1000 << " ms "
+            << gbs << " GB/s, dTLB misses " << r.dtlb_misses << ", on huge pages " << huge_bytes / (1024 * 1024)
+            << " MiB" << std::endl;
+  myfile << "hugepages_add" << ";" << conf.vector_size
+  << ";" << alloc
+  << ";" << pages
+  << ";" << phase
+  << ";" << r.us / 1000
+  << ";" << gbs
+  << ";" << r.dtlb_misses
+  << ";" << huge_bytes
+  << ";" << conf.omp_threads
+  << std::endl;
+}
+
+bool validate(const int *sum, size_t size)
+{
+  for (size_t i = 0; i < size; i++)
+  {
+    if (sum[i] != (int)(2 * i))
+    {
+      std::cout << "Vector add failed at index " << i << "\n";
+      return false;
+    }
+  }
+  return true;
+}
+
+//pages: the policy label of the rows, the one actually applied
+void run(std::ofstream &myfile, dtlb_counter &tlb, config conf, const std::string &alloc, const std::string &pages,
+         int *a, int *b, int *sum)
+{
+  phase_result first_touch = init(tlb, conf, a, b, sum);
+  report(myfile, conf, alloc, pages, "init", first_touch, huge_backed_bytes(a));
+
+  //warmup RUN!
+  add(tlb, conf, a, b, sum);
+  for (int r = 0; r < conf.repetitions; r++)
+    report(myfile, conf, alloc, pages, "add", add(tlb, conf, a, b, sum), huge_backed_bytes(a));
+  if (!validate(sum, conf.vector_size)) exit(-1);
+}
+
+int main(int argc, char* argv[]) {
+
+  config conf = ParseInputParams (argc, argv);
+  size_t bytes = conf.vector_size * sizeof(int);
+
+  //before the first OpenMP region so the inherited counter covers the team
+  dtlb_counter tlb;
+  if (!tlb.available())
+    std::cout << "dTLB miss counter not available (perf_event_paranoid or no PMU), reporting -1" << std::endl;
+
+  std::vector<page_policy> policies;
+  std::stringstream ss(conf.policies);
+  std::string item;
+  while (std::getline(ss, item, ',')) policies.push_back(parse_page_policy(item.c_str()));
+
+  std::ofstream myfile(conf.filename, std::ios_base::app);
+  if (myfile.tellp() == 0)
+    myfile << "benchmark;datasize;alloc;pages;phase;time_ms_chrono;gbs;dtlb_misses;huge_bytes;omp_threads" << std::endl;
+
+  try {
+    for (page_policy policy : policies)
+    {
+      if (conf.alloc == "host" || conf.alloc == "both")
+      {
+        page_policy used[3];
+        int *a = (int *)host_pages_alloc(bytes, policy, &used[0]);
+        int *b = (int *)host_pages_alloc(bytes, policy, &used[1]);
+        int *sum = (int *)host_pages_alloc(bytes, policy, &used[2]);
+        if (!a || !b || !sum) { std::cout << "Host memory allocation failure.\n"; exit(-1); }
+        //a partial hugetlb fallback is labelled as the fallback
+        page_policy applied = policy;
+        for (page_policy u : used) if (u != policy) applied = u;
+        run(myfile, tlb, conf, "host", page_policy_label(policy, applied), a, b, sum);
+        host_pages_free(a, bytes);
+        host_pages_free(b, bytes);
+        host_pages_free(sum, bytes);
+      }
+
+      if (conf.alloc == "shared" || conf.alloc == "both")
+      {
+        //not the runtime pool, a recycled block would keep the pages of its first policy
+        queue &q = coprocessing_runtime::instance().get_queue(conf.device_str);
+        int *a = malloc_shared<int>(conf.vector_size, q);
+        int *b = malloc_shared<int>(conf.vector_size, q);
+        int *sum = malloc_shared<int>(conf.vector_size, q);
+        if (!a || !b || !sum) { std::cout << "Shared memory allocation failure.\n"; exit(-1); }
+        for (int *p : {a, b, sum}) advise_pages(p, bytes, policy);
+        //the backend maps shared USM, hugetlb can only be advised as thp
+        page_policy applied = policy == page_policy::hugetlb ? page_policy::thp : policy;
+        run(myfile, tlb, conf, "shared", page_policy_label(policy, applied), a, b, sum);
+        free(a, q);
+        free(b, q);
+        free(sum, q);
+      }
+    }
+  } catch (exception const &e) {
+    std::cout << "An exception is caught while adding two vectors.\n";
+    std::terminate();
+  }
+  return 0;
+}
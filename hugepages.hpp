@@ -0,0 +1,197 @@
+#ifndef HUGEPAGES_HPP
+#define HUGEPAGES_HPP
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#ifndef MAP_HUGE_SHIFT
+#define MAP_HUGE_SHIFT 26
+#endif
+
+/**
+ * Page size policy for large host and shared allocations:
+ * system   no advice, whatever /sys/kernel/mm/transparent_hugepage says
+ * base     4 KiB pages, THP explicitly disabled for the range so the
+ *          baseline holds even with transparent_hugepage=always
+ * thp      madvise(MADV_HUGEPAGE), 2 MiB pages whenever khugepaged or the
+ *          fault path can get them
+ * hugetlb  MAP_HUGETLB from the reserved pool (vm.nr_hugepages), host only.
+ *          shared USM is mapped by the backend, there it falls back to thp
+ */
+enum class page_policy { system, base, thp, hugetlb };
+
+constexpr size_t huge_page_bytes = 2 * 1024 * 1024;
+
+inline page_policy parse_page_policy(const char *s)
+{
+  if (strcmp(s, "thp") == 0) return page_policy::thp;
+  if (strcmp(s, "hugetlb") == 0) return page_policy::hugetlb;
+  if (strcmp(s, "system") == 0) return page_policy::system;
+  if (strcmp(s, "4k") == 0 || strcmp(s, "base") == 0) return page_policy::base;
+  //a typo must not silently become the 4k baseline
+  std::cout << "unknown page policy " << s << ", using system" << std::endl;
+  return page_policy::system;
+}
+
+inline const char *page_policy_name(page_policy p)
+{
+  switch (p)
+  {
+    case page_policy::thp: return "thp";
+    case page_policy::hugetlb: return "hugetlb";
+    case page_policy::system: return "system";
+    default: return "4k";
+  }
+}
+
+inline size_t round_up_huge(size_t bytes)
+{
+  return (bytes + huge_page_bytes - 1) / huge_page_bytes * huge_page_bytes;
+}
+
+/**
+ * advise the 2 MiB aligned interior of [p, p+bytes). used on allocations we
+ * do not map ourselves, e.g. malloc_shared
+ */
+inline void advise_pages(void *p, size_t bytes, page_policy policy)
+{
+  uintptr_t begin = ((uintptr_t)p + huge_page_bytes - 1) & ~(uintptr_t)(huge_page_bytes - 1);
+  uintptr_t end = ((uintptr_t)p + bytes) & ~(uintptr_t)(huge_page_bytes - 1);
+  if (end <= begin || policy == page_policy::system) return;
+  madvise((void *)begin, end - begin, policy == page_policy::base ? MADV_NOHUGEPAGE : MADV_HUGEPAGE);
+}
+
+//requested policy, or "hugetlb->thp" style when another one was applied
+inline std::string page_policy_label(page_policy requested, page_policy used)
+{
+  if (requested == used) return page_policy_name(requested);
+  return std::string(page_policy_name(requested)) + "->" + page_policy_name(used);
+}
+
+/**
+ * anonymous mapping aligned to 2 MiB, so every huge page of the range can be
+ * backed. hugetlb falls back to thp if the pool is empty, the policy applied
+ * goes to used if given. nullptr on failure.
+ * release with host_pages_free and the same byte count
+ */
+inline void *host_pages_alloc(size_t bytes, page_policy policy, page_policy *used = nullptr)
+{
+  size_t len = round_up_huge(bytes);
+  if (used != nullptr) *used = policy;
+  if (policy == page_policy::hugetlb)
+  {
+    void *p = mmap(nullptr, len, PROT_READ | PROT_WRITE,
+                   MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB | (21 << MAP_HUGE_SHIFT), -1, 0);
+    if (p != MAP_FAILED) return p;
+    std::cout << "MAP_HUGETLB failed, reserve pages with vm.nr_hugepages. using thp" << std::endl;
+    policy = page_policy::thp;
+    if (used != nullptr) *used = policy;
+  }
+
+  //over-map by one huge page and trim both ends to the alignment
+  void *raw = mmap(nullptr, len + huge_page_bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (raw == MAP_FAILED) return nullptr;
+  uintptr_t r = (uintptr_t)raw;
+  uintptr_t aligned = (r + huge_page_bytes - 1) & ~(uintptr_t)(huge_page_bytes - 1);
+  if (aligned > r) munmap(raw, aligned - r);
+  munmap((void *)(aligned + len), r + huge_page_bytes - aligned);
+  advise_pages((void *)aligned, len, policy);
+  return (void *)aligned;
+}
+
+inline void host_pages_free(void *p, size_t bytes)
+{
+  if (p != nullptr) munmap(p, round_up_huge(bytes));
+}
+
+/**
+ * bytes of the mapping containing p that are backed by huge pages, from
+ * /proc/self/smaps: AnonHugePages for thp, the whole Rss for hugetlb
+ */
+inline size_t huge_backed_bytes(const void *p)
+{
+  std::ifstream smaps("/proc/self/smaps");
+  std::string line;
+  bool inside = false;
+  size_t kernel_page_kb = 4, rss_kb = 0, anon_huge_kb = 0;
+  while (std::getline(smaps, line))
+  {
+    uintptr_t lo, hi;
+    if (sscanf(line.c_str(), "%lx-%lx ", &lo, &hi) == 2)
+    {
+      if (inside) break;
+      inside = (uintptr_t)p >= lo && (uintptr_t)p < hi;
+      continue;
+    }
+    if (!inside) continue;
+    std::istringstream ls(line);
+    std::string key;
+    size_t kb = 0;
+    ls >> key >> kb;
+    if (key == "Rss:") rss_kb = kb;
+    else if (key == "AnonHugePages:") anon_huge_kb = kb;
+    else if (key == "KernelPageSize:") kernel_page_kb = kb;
+  }
+  return 1024 * (kernel_page_kb > 4 ? rss_kb : anon_huge_kb);
+}
+
+/**
+ * dTLB load miss counter for this process. opened disabled with inherit, so
+ * it must be created before the OpenMP team to cover the worker threads.
+ * available() is false where perf events are not permitted
+ * (perf_event_paranoid) or the PMU does not expose the event, e.g. most VMs
+ */
+class dtlb_counter
+{
+ public:
+  dtlb_counter()
+  {
+    perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = PERF_TYPE_HW_CACHE;
+    attr.config = PERF_COUNT_HW_CACHE_DTLB | (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                  (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+    attr.disabled = 1;
+    attr.inherit = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    fd = syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+  }
+  ~dtlb_counter() { if (fd >= 0) close(fd); }
+  dtlb_counter(const dtlb_counter &) = delete;
+
+  bool available() const { return fd >= 0; }
+
+  void start()
+  {
+    if (fd < 0) return;
+    ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+    ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+  }
+
+  //misses since start, -1 if not available
+  long long stop()
+  {
+    if (fd < 0) return -1;
+    ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+    long long count = 0;
+    if (read(fd, &count, sizeof(count)) != sizeof(count)) return -1;
+    return count;
+  }
+
+ private:
+  int fd = -1;
+};
+
+#endif // HUGEPAGES_HPP
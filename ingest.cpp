@@ -0,0 +1,349 @@
+#include <sycl/sycl.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <omp.h>
+#include <unistd.h>
+#if FPGA_HARDWARE || FPGA_EMULATOR || FPGA_SIMULATOR
+#include <sycl/ext/intel/fpga_extensions.hpp>
+#include "kernels.hpp"
+#endif
+
+#include "column_file.hpp"
+#include "elementwise.hpp"
+#include "runtime.hpp"
+
+
+using namespace sycl;
+
+/**
+ * Sum of a raw int32 column file streamed from the page cache or disk.
+ * the file is mapped (column_file) and walked in chunks. each chunk is split
+ * like every co-processing run, make_split with -s: the cpu sums [0, start)
+ * straight from the mapping in an OpenMP team, the device part is packed
+ * into a pinned staging slot, copied to a device slot and reduced there.
+ * depth slots rotate, so while the device copies and reduces chunk k the
+ * host pages in and packs chunk k + 1, and the kernel reads ahead chunks up
+ * to k + depth (will_need).
+ * cold runs evict the file from the page cache first, warm runs read it
+ * once before; both report end-to-end GB/s over the file size, from mapping
+ * to final sum, and the resident fraction of the file at the start.
+ * -t fpga feeds the pinned chunks to aggregation_kernel from kernels.cpp
+ * instead, built only with -DFPGA_HARDWARE, -DFPGA_EMULATOR or
+ * -DFPGA_SIMULATOR. that kernel blocks, so only page-in overlaps.
+ */
+struct config
+{
+ std::string path = "column.bin";
+ size_t generate_mib = 0; //write a test column of this size first
+ size_t chunk_elements = 4*1024*1024; //16 MiB
+ int depth = 3; //staging slots in flight
+ float share_cpu = 0.f;
+ int omp_threads = 8;
+ std::string caches = "cold,warm";
+ std::string target = "sycl";
+ std::string device_str = "gpu";
+ std::string filename = "ingest.csv";
+};
+
+/**
+ * -f column file, raw int32
+ * -gen write a test column of this many MiB to -f first
+ * -chunk chunk size in MiB
+ * -depth staging slots in flight
+ * -s share cpu factor 0..1 of every chunk
+ * -omp openmp threads
+ * -cache comma separated cold, warm
+ * -t sycl or fpga
+ * -d device sycl cpu or gpu
+ * -o output filename
+ */
+config ParseInputParams (int argc, char** argv)
+{
+  config conf;
+ int w_argc = argc - 1; // remaining arg count
+    while (w_argc > 0) {
+        char* w_arg = argv[argc - (w_argc--)]; // working arg
+        char* n_arg = (w_argc > 0) ? argv[argc - w_argc] : NULL; // next arg
+
+        if (strcmp(w_arg, "-f") == 0) {
+            w_argc--;
+            conf.path = n_arg;
+        }
+        else if (strcmp(w_arg, "-gen") == 0) {
+            w_argc--;
+            conf.generate_mib = atol(n_arg);
+        }
+        else if (strcmp(w_arg, "-chunk") == 0) {
+            w_argc--;
+            conf.chunk_elements = std::max<size_t>(1, atol(n_arg)) * 256 * 1024;
+        }
+        else if (strcmp(w_arg, "-depth") == 0) {
+            w_argc--;
+            conf.depth = std::max(1, atoi(n_arg));
+        }
+        else if (strcmp(w_arg, "-s") == 0) {
+            w_argc--;
+            conf.share_cpu = atof(n_arg);
+        }
+        else if (strcmp(w_arg, "-omp") == 0) {
+            w_argc--;
+            conf.omp_threads = std::max(1, atoi(n_arg));
+        }
+        else if (strcmp(w_arg, "-cache") == 0) {
+            w_argc--;
+            conf.caches = n_arg;
+        }
+        else if (strcmp(w_arg, "-t") == 0) {
+            w_argc--;
+            conf.target = n_arg;
+        }
+        else if (strcmp(w_arg, "-d") == 0) {
+            w_argc--;
+            conf.device_str = n_arg;
+        }
+        else if (strcmp(w_arg, "-o") == 0) {
+            w_argc--;
+            conf.filename = n_arg;
+        }
+}
+
+return conf;
+}
+
+int64_t host_sum(int omp_threads, const int32_t *in, size_t begin, size_t end)
+{
+  int64_t s = 0;
+  #pragma omp parallel for num_threads(omp_threads) reduction(+ : s)
+  for (size_t i = begin; i < end; i++) s += in[i];
+  return s;
+}
+
+//copy from the mapping into pinned memory, the page faults are taken here
+void pack(int omp_threads, int32_t *dst, const int32_t *src, size_t n)
+{
+  #pragma omp parallel for num_threads(omp_threads) schedule(static)
+  for (size_t i = 0; i < n; i++) dst[i] = src[i];
+}
+
+struct ingest_result
+{
+  int64_t total = 0;
+  double ms = 0;
+  double resident = 0;
+};
+
+/**
+ * stream the column through depth staging slots on dev, returns the sum
+ */
+ingest_result ingest_sycl(config conf, coprocessing_runtime::device_entry &dev)
+{
+  ingest_result res;
+  auto t1 = std::chrono::steady_clock::now();
+  column_file col(conf.path);
+  res.resident = col.resident_fraction();
+  const int32_t *in = col.data();
+  size_t n = col.elements();
+  size_t chunk = std::min(conf.chunk_elements, std::max<size_t>(n, 1));
+  size_t chunks = (n + chunk - 1) / chunk;
+
+  std::vector<int32_t *> staging(conf.depth), slot(conf.depth);
+  std::vector<event> done(conf.depth);
+  int64_t *partial = dev.pool().acquire<int64_t>(std::max<size_t>(chunks, 1));
+  for (int s = 0; s < conf.depth; s++)
+  {
+    staging[s] = dev.pool(usm::alloc::host).acquire<int32_t>(chunk);
+    slot[s] = dev.pool(usm::alloc::device).acquire<int32_t>(chunk);
+    if (staging[s] == nullptr || slot[s] == nullptr || partial == nullptr) {
+      std::cout << "Staging memory allocation failure.\n";
+      exit(-1);
+    }
+  }
+  std::fill(partial, partial + chunks, 0);
+
+  int64_t cpu_total = 0;
+  col.will_need(0, (size_t)conf.depth * chunk);
+  for (size_t k = 0; k < chunks; k++)
+  {
+    int s = k % conf.depth;
+    size_t begin = k * chunk;
+    size_t len = std::min(chunk, n - begin);
+    col.will_need(begin + (size_t)conf.depth * chunk, begin + (size_t)(conf.depth + 1) * chunk);
+    coprocess_split split = make_split(len, conf.share_cpu, conf.omp_threads);
+    size_t start = std::min(split.start_index, len);
+
+    if (start < len)
+    {
+      //slot s is free once the reduction of chunk k - depth is done
+      done[s].wait();
+      size_t dev_len = len - start;
+      pack(conf.omp_threads, staging[s], in + begin + start, dev_len);
+      event copied = dev.q.memcpy(slot[s], staging[s], dev_len * sizeof(int32_t));
+      int32_t *d = slot[s];
+      int64_t *out = partial + k;
+      done[s] = dev.q.submit([&](handler &h) {
+        h.depends_on(copied);
+        h.parallel_for(range<1>{dev_len}, reduction(out, plus<int64_t>()), [=](id<1> i, auto &acc) { acc += d[i]; });
+      });
+    }
+    if (start > 0) cpu_total += host_sum(conf.omp_threads, in, begin, begin + start);
+  }
+  dev.q.wait();
+  res.total = cpu_total;
+  for (size_t k = 0; k < chunks; k++) res.total += partial[k];
+  auto t2 = std::chrono::steady_clock::now();
+  res.ms = std::chrono::duration<double, std::milli>(t2 - t1).count();
+
+  for (int s = 0; s < conf.depth; s++)
+  {
+    dev.pool(usm::alloc::host).release(staging[s]);
+    dev.pool(usm::alloc::device).release(slot[s]);
+  }
+  dev.pool().release(partial);
+  return res;
+}
+
+#if FPGA_HARDWARE || FPGA_EMULATOR || FPGA_SIMULATOR
+//aggregation_kernel over pinned chunks, a multiple of 16 elements each, tails on the host
+ingest_result ingest_fpga(config conf, queue &q)
+{
+  ingest_result res;
+  auto t1 = std::chrono::steady_clock::now();
+  column_file col(conf.path);
+  res.resident = col.resident_fraction();
+  const int32_t *in = col.data();
+  size_t n = col.elements();
+  size_t chunk = std::max<size_t>(16, conf.chunk_elements / 16 * 16);
+  int *staging = malloc_host<int>(chunk, q);
+  long *out = malloc_host<long>(1, q);
+  if (staging == nullptr || out == nullptr) {
+    std::cout << "Staging memory allocation failure.\n";
+    exit(-1);
+  }
+  for (size_t begin = 0; begin < n; begin += chunk)
+  {
+    size_t len = std::min(chunk, n - begin);
+    size_t fpga_len = len / 16 * 16;
+    col.will_need(begin + chunk, begin + (size_t)(conf.depth + 1) * chunk);
+    pack(conf.omp_threads, staging, in + begin, fpga_len);
+    if (fpga_len > 0)
+    {
+      aggregation_kernel(q, staging, out, fpga_len);
+      res.total += out[0];
+    }
+    res.total += host_sum(conf.omp_threads, in, begin + fpga_len, begin + len);
+  }
+  auto t2 = std::chrono::steady_clock::now();
+  res.ms = std::chrono::duration<double, std::milli>(t2 - t1).count();
+  free(staging, q);
+  free(out, q);
+  return res;
+}
+#endif
+
+std::vector<std::string> split_list(const std::string &list)
+{
+  std::vector<std::string> items;
+  std::stringstream ss(list);
+  std::string item;
+  while (std::getline(ss, item, ',')) items.push_back(item);
+  return items;
+}
+
+int main(int argc, char* argv[]) {
+
+  config conf = ParseInputParams (argc, argv);
+
+  if (conf.generate_mib > 0)
+  {
+    std::cout << "writing " << conf.generate_mib << " MiB to " << conf.path << std::endl;
+    if (!column_file::generate(conf.path, conf.generate_mib * 256 * 1024)) {
+      std::cout << "could not write " << conf.path << std::endl;
+      exit(-1);
+    }
+  }
+
+  //reference sum from a plain host pass, this also warms the cache
+  int64_t expected = 0;
+  size_t file_bytes = 0;
+  {
+    column_file col(conf.path);
+    expected = host_sum(conf.omp_threads, col.data(), 0, col.elements());
+    file_bytes = col.bytes();
+  }
+
+  std::ofstream myfile(conf.filename, std::ios_base::app);
+  if (myfile.tellp() == 0)
+    myfile << "benchmark;file_bytes;device;target;cache;chunk_bytes;depth;cpu_share;resident_before;time_ms;gbs" << std::endl;
+
+  try {
+#if FPGA_HARDWARE || FPGA_EMULATOR || FPGA_SIMULATOR
+#if FPGA_SIMULATOR
+    auto selector = sycl::ext::intel::fpga_simulator_selector_v;
+#elif FPGA_HARDWARE
+    auto selector = sycl::ext::intel::fpga_selector_v;
+#else
+    auto selector = sycl::ext::intel::fpga_emulator_selector_v;
+#endif
+    std::unique_ptr<queue> fpga_q;
+    if (conf.target == "fpga") fpga_q.reset(new queue(selector));
+#else
+    if (conf.target == "fpga") {
+      std::cout << "fpga target skipped, build with -DFPGA_HARDWARE or -DFPGA_EMULATOR" << std::endl;
+      return 0;
+    }
+#endif
+    auto &dev = coprocessing_runtime::instance().get(conf.device_str);
+    std::string device_name = dev.q.get_device().get_info<info::device::name>();
+    std::cout << "Running on device: " << device_name << "\n";
+
+    //warmup RUN! first use of the pools and the kernels
+#if FPGA_HARDWARE || FPGA_EMULATOR || FPGA_SIMULATOR
+    if (conf.target == "fpga") ingest_fpga(conf, *fpga_q);
+    else
+#endif
+    ingest_sycl(conf, dev);
+
+    for (auto &cache : split_list(conf.caches))
+    {
+      if (cache == "cold") column_file::evict(conf.path);
+      else if (cache == "warm") { column_file col(conf.path); host_sum(conf.omp_threads, col.data(), 0, col.elements()); }
+      else continue;
+
+      ingest_result res;
+#if FPGA_HARDWARE || FPGA_EMULATOR || FPGA_SIMULATOR
+      if (conf.target == "fpga") res = ingest_fpga(conf, *fpga_q);
+      else
+#endif
+      res = ingest_sycl(conf, dev);
+
+      if (res.total != expected) {
+        std::cout << cache << " ingest sum " << res.total << " differs from " << expected << std::endl;
+        exit(-1);
+      }
+      double gbs = file_bytes / (res.ms * 1e6);
+      std::cout << cache << ": " << gbs << " GB/s, " << res.ms << " ms, " << res.resident * 100
+                << " % resident before" << std::endl;
+      myfile << "ingest" << ";" << file_bytes
+      << ";" << device_name
+      << ";" << conf.target
+      << ";" << cache
+      << ";" << conf.chunk_elements * sizeof(int32_t)
+      << ";" << conf.depth
+      << ";" << conf.share_cpu
+      << ";" << res.resident
+      << ";" << res.ms
+      << ";" << gbs
+      << std::endl;
+    }
+  } catch (exception const &e) {
+    std::cout << "An exception is caught while ingesting the column.\n";
+    std::terminate();
+  }
+  return 0;
+}
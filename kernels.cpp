@@ -42,4 +42,107 @@ void aggregation_kernel(queue& q, int *in_host, long *out_host, size_t size) {
   }).wait();
  
    
-}
\ No newline at end of file
+}
+
+class stream_copy;
+class stream_scale;
+class stream_add;
+class stream_triad;
+
+// c = a
+void stream_copy_kernel(queue& q, int *a_host, int *c_host, size_t size) {
+
+  size_t iterations = size / 16;
+
+ q.submit([&](handler& h) {
+    h.single_task<stream_copy>([=]() [[intel::kernel_args_restrict]] {
+
+      host_ptr<int> a(a_host);
+      host_ptr<int> c(c_host);
+
+      fpvec<int> dataVec;
+
+      for (size_t i_cnt = 0; i_cnt < iterations; i_cnt++) {
+            dataVec = load<int>(a, i_cnt);
+            store<int>(c, i_cnt, dataVec);
+      }
+    });
+
+  }).wait();
+}
+
+// b = scalar * c
+void stream_scale_kernel(queue& q, int *c_host, int *b_host, int scalar, size_t size) {
+
+  size_t iterations = size / 16;
+
+ q.submit([&](handler& h) {
+    h.single_task<stream_scale>([=]() [[intel::kernel_args_restrict]] {
+
+      host_ptr<int> c(c_host);
+      host_ptr<int> b(b_host);
+
+      fpvec<int> dataVec;
+
+      for (size_t i_cnt = 0; i_cnt < iterations; i_cnt++) {
+            dataVec = load<int>(c, i_cnt);
+            dataVec = mul<int>(dataVec, scalar);
+            store<int>(b, i_cnt, dataVec);
+      }
+    });
+
+  }).wait();
+}
+
+// c = a + b
+void stream_add_kernel(queue& q, int *a_host, int *b_host, int *c_host, size_t size) {
+
+  size_t iterations = size / 16;
+
+ q.submit([&](handler& h) {
+    h.single_task<stream_add>([=]() [[intel::kernel_args_restrict]] {
+
+      host_ptr<int> a(a_host);
+      host_ptr<int> b(b_host);
+      host_ptr<int> c(c_host);
+
+      fpvec<int> aVec;
+      fpvec<int> bVec;
+
+      for (size_t i_cnt = 0; i_cnt < iterations; i_cnt++) {
+            aVec = load<int>(a, i_cnt);
+            bVec = load<int>(b, i_cnt);
+            aVec = add(aVec, bVec);
+            store<int>(c, i_cnt, aVec);
+      }
+    });
+
+  }).wait();
+}
+
+// a = b + scalar * c
+void stream_triad_kernel(queue& q, int *a_host, int *b_host, int *c_host, int scalar, size_t size) {
+
+  size_t iterations = size / 16;
+
+ q.submit([&](handler& h) {
+    h.single_task<stream_triad>([=]() [[intel::kernel_args_restrict]] {
+
+      host_ptr<int> a(a_host);
+      host_ptr<int> b(b_host);
+      host_ptr<int> c(c_host);
+
+      fpvec<int> bVec;
+      fpvec<int> cVec;
+
+      for (size_t i_cnt = 0; i_cnt < iterations; i_cnt++) {
+            bVec = load<int>(b, i_cnt);
+            cVec = load<int>(c, i_cnt);
+            cVec = mul<int>(cVec, scalar);
+            bVec = add(bVec, cVec);
+            store<int>(a, i_cnt, bVec);
+      }
+    });
+
+  }).wait();
+}
@@ -6,4 +6,10 @@ using namespace sycl;
 
 void aggregation_kernel(queue& q, int *in_host, long *out_host, size_t size);
 
+// STREAM kernels, size is a multiple of 16 (one 512-bit line per iteration)
+void stream_copy_kernel(queue& q, int *a_host, int *c_host, size_t size);
+void stream_scale_kernel(queue& q, int *c_host, int *b_host, int scalar, size_t size);
+void stream_add_kernel(queue& q, int *a_host, int *b_host, int *c_host, size_t size);
+void stream_triad_kernel(queue& q, int *a_host, int *b_host, int *c_host, int scalar, size_t size);
+
 #endif
\ No newline at end of file
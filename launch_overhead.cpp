@@ -0,0 +1,293 @@
+#include <sycl/sycl.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <omp.h>
+
+#include "multi_device.hpp"
+
+
+using namespace sycl;
+
+/**
+ * Round trip cost of one launch: submit and wait, launches times per variant.
+ * per device (every usable CPU and GPU, see usable_devices) the queue is
+ * in-order or out-of-order, with or without enable_profiling and, for
+ * in-order queues without profiling, with discard_events. kernels:
+ * empty single_task, empty parallel_for over one item and a tiny
+ * parallel_for add over -k elements. completion is always q.wait(), the
+ * events of a discard_events queue cannot be waited on.
+ * host rows are the OpenMP counterpart: an empty parallel region and the
+ * tiny add in one.
+ * break-even: per device the smallest size at which submitting VectorAdd on
+ * shared USM and waiting beats the same add in an OpenMP team on the host,
+ * sizes doubling from -min to -max. 0 if the host is faster everywhere.
+ */
+struct config
+{
+ int launches =1000;
+ size_t tiny_size =256; //elements of the tiny kernel
+ size_t min_size =256;
+ size_t max_size =1024*1024*64;
+ int repetitions =20; //per break-even size
+ int omp_threads =8;
+ std::string platform_filter = "";
+ std::string filename = "launch_overhead.csv";
+};
+
+/**
+ * -n launches per variant
+ * -k elements of the tiny kernel
+ * -min smallest break-even size in elements
+ * -max largest break-even size in elements
+ * -r repetitions per break-even size
+ * -omp openmp threads of the host side
+ * -platform only devices of platforms whose name contains this
+ * -o output filename
+ */
+config ParseInputParams (int argc, char** argv)
+{
+  config conf;
+ int w_argc = argc - 1; // remaining arg count
+    while (w_argc > 0) {
+        char* w_arg = argv[argc - (w_argc--)]; // working arg
+        char* n_arg = (w_argc > 0) ? argv[argc - w_argc] : NULL; // next arg
+
+        if (strcmp(w_arg, "-n") == 0) {
+            w_argc--;
+            conf.launches = std::max(1, atoi(n_arg));
+        }
+        else if (strcmp(w_arg, "-k") == 0) {
+            w_argc--;
+            conf.tiny_size = std::max<size_t>(1, atol(n_arg));
+        }
+        else if (strcmp(w_arg, "-min") == 0) {
+            w_argc--;
+            conf.min_size = std::max<size_t>(1, atol(n_arg));
+        }
+        else if (strcmp(w_arg, "-max") == 0) {
+            w_argc--;
+            conf.max_size = std::max<size_t>(1, atol(n_arg));
+        }
+        else if (strcmp(w_arg, "-r") == 0) {
+            w_argc--;
+            conf.repetitions = std::max(1, atoi(n_arg));
+        }
+        else if (strcmp(w_arg, "-omp") == 0) {
+            w_argc--;
+            conf.omp_threads = std::max(1, atoi(n_arg));
+        }
+        else if (strcmp(w_arg, "-platform") == 0) {
+            w_argc--;
+            conf.platform_filter = n_arg;
+        }
+        else if (strcmp(w_arg, "-o") == 0) {
+            w_argc--;
+            conf.filename = n_arg;
+        }
+}
+
+return conf;
+}
+
+struct queue_variant
+{
+  bool in_order;
+  bool profiling;
+  bool discard_events;
+};
+
+queue make_queue(const device &d, queue_variant v)
+{
+  if (v.in_order && v.discard_events)
+    return queue(d, property_list{property::queue::in_order{}, ext::oneapi::property::queue::discard_events{}});
+  if (v.in_order && v.profiling)
+    return queue(d, property_list{property::queue::in_order{}, property::queue::enable_profiling{}});
+  if (v.in_order) return queue(d, property_list{property::queue::in_order{}});
+  if (v.profiling) return queue(d, property_list{property::queue::enable_profiling{}});
+  return queue(d);
+}
+
+struct distribution
+{
+  double min = 0, p50 = 0, p90 = 0, p99 = 0, mean = 0;
+};
+
+distribution distribution_of(std::vector<double> v)
+{
+  distribution d;
+  std::sort(v.begin(), v.end());
+  auto at = [&](double p) { return v[std::min(v.size() - 1, (size_t)(p * v.size()))]; };
+  d.min = v.front();
+  d.p50 = at(0.5);
+  d.p90 = at(0.9);
+  d.p99 = at(0.99);
+  for (double x : v) d.mean += x;
+  d.mean /= v.size();
+  return d;
+}
+
+//launches round trips of launch(), the first one is a warmup and not counted
+template<typename F>
+std::vector<double> round_trips(int launches, F launch)
+{
+  std::vector<double> us;
+  launch();
+  for (int i = 0; i < launches; i++)
+  {
+    auto t1 = std::chrono::steady_clock::now();
+    launch();
+    auto t2 = std::chrono::steady_clock::now();
+    us.push_back(std::chrono::duration<double, std::micro>(t2 - t1).count());
+  }
+  return us;
+}
+
+void write_row(std::ofstream &myfile, const std::string &device, const std::string &queue_kind, bool profiling,
+               bool discard, const std::string &kernel, size_t size, int launches, distribution d)
+{
+  std::cout << device << " " << queue_kind << (profiling ? " profiling" : "") << (discard ? " discard_events" : "")
+            << " " << kernel << ": p50 " << d.p50 << " us p99 " << d.p99 << " us" << std::endl;
+  myfile << "launch_overhead" << ";" << device
+  << ";" << queue_kind
+  << ";" << profiling
+  << ";" << discard
+  << ";" << kernel
+  << ";" << size
+  << ";" << launches
+  << ";" << d.min
+  << ";" << d.p50
+  << ";" << d.p90
+  << ";" << d.p99
+  << ";" << d.mean
+  << std::endl;
+}
+
+void host_add(int omp_threads, const int *a, const int *b, int *sum, size_t size)
+{
+  #pragma omp parallel for num_threads(omp_threads) schedule(static)
+  for (size_t i = 0; i < size; i++) sum[i] = a[i] + b[i];
+}
+
+double median_us(std::vector<double> v)
+{
+  std::sort(v.begin(), v.end());
+  return v[v.size() / 2];
+}
+
+//smallest size where offload round trip beats the OpenMP host add, 0 if none
+size_t break_even(config conf, const device &d, const std::string &name)
+{
+  queue q(d, property::queue::in_order{});
+  for (size_t size = conf.min_size; size <= conf.max_size; size *= 2)
+  {
+    int *a = malloc_shared<int>(size, q);
+    int *b = malloc_shared<int>(size, q);
+    int *sum = malloc_shared<int>(size, q);
+    if (!a || !b || !sum) {
+      std::cout << "Shared memory allocation failure.\n";
+      exit(-1);
+    }
+    for (size_t i = 0; i < size; i++) a[i] = b[i] = i;
+
+    double host = median_us(round_trips(conf.repetitions, [&]() { host_add(conf.omp_threads, a, b, sum, size); }));
+    double offload = median_us(round_trips(conf.repetitions, [&]() {
+      q.parallel_for(range<1>{size}, [=](id<1> i) { sum[i] = a[i] + b[i]; });
+      q.wait();
+    }));
+    free(a, q);
+    free(b, q);
+    free(sum, q);
+
+    if (offload < host)
+    {
+      std::cout << name << ": offload wins from " << size << " elements, " << offload << " us against host "
+                << host << " us" << std::endl;
+      return size;
+    }
+  }
+  std::cout << name << ": host add faster up to " << conf.max_size << " elements" << std::endl;
+  return 0;
+}
+
+int main(int argc, char* argv[]) {
+
+  config conf = ParseInputParams (argc, argv);
+
+  std::ofstream myfile(conf.filename, std::ios_base::app);
+  if (myfile.tellp() == 0)
+    myfile << "benchmark;device;queue;profiling;discard_events;kernel;datasize;launches;us_min;us_p50;us_p90;us_p99;us_mean" << std::endl;
+
+  //host: OpenMP fork/join and the tiny add
+  {
+    std::vector<int> a(conf.tiny_size, 1), b(conf.tiny_size, 2), sum(conf.tiny_size);
+    write_row(myfile, "host", "omp", false, false, "empty parallel region", 0, conf.launches,
+              distribution_of(round_trips(conf.launches, [&]() {
+                #pragma omp parallel num_threads(conf.omp_threads)
+                {
+                }
+              })));
+    write_row(myfile, "host", "omp", false, false, "tiny add", conf.tiny_size, conf.launches,
+              distribution_of(round_trips(conf.launches, [&]() {
+                host_add(conf.omp_threads, a.data(), b.data(), sum.data(), conf.tiny_size);
+              })));
+  }
+
+  const std::vector<queue_variant> variants{
+      {true, false, false}, {true, true, false}, {true, false, true}, {false, false, false}, {false, true, false}};
+
+  try {
+    for (auto &d : usable_devices(conf.platform_filter))
+    {
+      if (!d.is_cpu() && !d.is_gpu()) continue;
+      std::string name = d.get_info<info::device::name>();
+      std::cout << "Running on device: " << name << "\n";
+
+      for (auto v : variants)
+      {
+        queue q = make_queue(d, v);
+        std::string kind = v.in_order ? "in_order" : "out_of_order";
+        size_t n = conf.tiny_size;
+        int *a = malloc_shared<int>(n, q);
+        int *b = malloc_shared<int>(n, q);
+        int *sum = malloc_shared<int>(n, q);
+        if (!a || !b || !sum) {
+          std::cout << "Shared memory allocation failure.\n";
+          exit(-1);
+        }
+        for (size_t i = 0; i < n; i++) a[i] = b[i] = i;
+
+        write_row(myfile, name, kind, v.profiling, v.discard_events, "empty single_task", 0, conf.launches,
+                  distribution_of(round_trips(conf.launches, [&]() {
+                    q.single_task([=]() {});
+                    q.wait();
+                  })));
+        write_row(myfile, name, kind, v.profiling, v.discard_events, "empty parallel_for", 1, conf.launches,
+                  distribution_of(round_trips(conf.launches, [&]() {
+                    q.parallel_for(range<1>{1}, [=](id<1>) {});
+                    q.wait();
+                  })));
+        write_row(myfile, name, kind, v.profiling, v.discard_events, "tiny add", n, conf.launches,
+                  distribution_of(round_trips(conf.launches, [&]() {
+                    q.parallel_for(range<1>{n}, [=](id<1> i) { sum[i] = a[i] + b[i]; });
+                    q.wait();
+                  })));
+        free(a, q);
+        free(b, q);
+        free(sum, q);
+      }
+
+      size_t even = break_even(conf, d, name);
+      myfile << "break_even" << ";" << name << ";in_order;0;0;add vs omp;" << even << ";" << conf.repetitions
+             << ";-;-;-;-;-" << std::endl;
+    }
+  } catch (exception const &e) {
+    std::cout << "An exception is caught while measuring launches.\n";
+    std::terminate();
+  }
+  return 0;
+}
@@ -0,0 +1,73 @@
+#ifndef MULTI_DEVICE_HPP
+#define MULTI_DEVICE_HPP
+
+#include <sycl/sycl.hpp>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace sycl;
+
+/**
+ * All devices that can run the co-processing kernels (shared USM support),
+ * in platform enumeration order. platform_filter keeps only platforms whose
+ * name contains it, so the same hardware is not picked up twice through two
+ * backends. with cpu_sub_devices > 1 every CPU device is replaced by that
+ * many equal sub-devices.
+ */
+inline std::vector<device> usable_devices(const std::string &platform_filter = "",
+                                          unsigned cpu_sub_devices = 0)
+{
+  std::vector<device> found;
+  for (auto platform : platform::get_platforms())
+  {
+    std::string pname = platform.get_info<info::platform::name>();
+    if (!platform_filter.empty() && pname.find(platform_filter) == std::string::npos) continue;
+
+    for (auto d : platform.get_devices())
+    {
+      if (!d.get_info<info::device::usm_shared_allocations>()) continue;
+
+      if (d.is_cpu() && cpu_sub_devices > 1)
+      {
+        try {
+          unsigned per_sub = d.get_info<info::device::max_compute_units>() / cpu_sub_devices;
+          auto subs = d.create_sub_devices<info::partition_property::partition_equally>(per_sub > 0 ? per_sub : 1);
+          found.insert(found.end(), subs.begin(), subs.end());
+          continue;
+        } catch (exception const &e) {
+          std::cout << "could not partition " << d.get_info<info::device::name>()
+                    << ", using it as one device" << std::endl;
+        }
+      }
+      found.push_back(d);
+    }
+  }
+  return found;
+}
+
+/**
+ * contiguous [begin, end) ranges proportional to weights, the last range
+ * takes the rounding remainder
+ */
+inline std::vector<std::pair<size_t, size_t>> weighted_ranges(const std::vector<float> &weights, size_t size)
+{
+  float total = 0.f;
+  for (float w : weights) total += w;
+
+  std::vector<std::pair<size_t, size_t>> ranges;
+  size_t begin = 0;
+  float acc = 0.f;
+  for (size_t t = 0; t < weights.size(); t++)
+  {
+    acc += weights[t];
+    size_t end = (t + 1 == weights.size() || total <= 0.f) ? size : (size_t)(size * (acc / total));
+    if (end < begin) end = begin;
+    if (end > size) end = size;
+    ranges.push_back({begin, end});
+    begin = end;
+  }
+  return ranges;
+}
+
+#endif // MULTI_DEVICE_HPP
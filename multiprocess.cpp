@@ -6,8 +6,12 @@
 #include <omp.h>
 #include <thread>
 #include <chrono>
-#include <sys/ipc.h>
-#include <sys/shm.h>
+#include <memory>
+
+#include "validation.hpp"
+#include "process_barrier.hpp"
+#include "shared_dataset.hpp"
+#include "trace.hpp"
 
 
 
@@ -27,13 +31,20 @@ struct config
  size_t mib=0;
  bool usm=true;
  bool do_validation=true;
+ validation_mode validation=validation_mode::full;
  hardware hw=cpu;
  std::string device_str = "cpu";
  std::string filename = "add_gpu.csv";
  float share_cpu =1.f;
  size_t start_index=0;
  std::string processing_mode ="";
- bool write =false;
+ bool write =false; //old start signal writer, every process joins the barrier now
+ int processes =2; //participants of the start barrier
+ int spin_us =200; //spin before sleeping on the barrier futex
+ std::string barrier_key = "shmfile";
+ bool shared_input =false; //map a and b from one shm dataset built by the first process
+ std::string dataset_name = "coprocessing_inputs";
+ std::string trace_prefix = ""; //per process timeline <prefix>.<pid>.trace, merged by trace_merge
 };
 
 struct times
@@ -68,10 +79,18 @@ static auto exception_handler = [](sycl::exception_list e_list) {
  * -k size in KiB
  * -m size in MiB
  * -d device sycl cpu or gpu
- * --nv no validation
+ * --nv no validation, same as -val none
+ * -val validation mode none, serial, full, sampled or checksum
  * -o output filename
  * -s share cpu factor 0..1
  * -omp openmp threads int
+ * -p number of processes meeting at the start barrier
+ * -spin us to spin before sleeping in the barrier
+ * -key barrier key file for ftok, created if missing
+ * -w accepted for old scripts, ignored
+ * -shared-input map a and b read-only from one dataset shared by all processes
+ * -dataset name of the shm object for -shared-input
+ * -trace file prefix for the timeline of this process, see trace_merge
  */
 config ParseInputParams (int argc, char** argv)
 {
@@ -82,9 +101,14 @@ config ParseInputParams (int argc, char** argv)
         char* n_arg = (w_argc > 0) ? argv[argc - w_argc] : NULL; // next arg
 
         if (strcmp(w_arg, "--nv") == 0) {
-            w_argc--;
             conf.do_validation = false;
-        
+            conf.validation = validation_mode::none;
+        }
+
+        else if (strcmp(w_arg, "-val") == 0) {
+            w_argc--;
+            conf.validation = parse_validation_mode(n_arg);
+            conf.do_validation = conf.validation != validation_mode::none;
         }
 
         else if (strcmp(w_arg, "-k") == 0) {
@@ -144,9 +168,31 @@ config ParseInputParams (int argc, char** argv)
             conf.filename = ofile;
         }
         else if (strcmp(w_arg, "-w") == 0) {
-            w_argc--;
             conf.write = true;
         }
+        else if (strcmp(w_arg, "-p") == 0) {
+            w_argc--;
+            conf.processes = std::max(1, atoi(n_arg));
+        }
+        else if (strcmp(w_arg, "-spin") == 0) {
+            w_argc--;
+            conf.spin_us = std::max(0, atoi(n_arg));
+        }
+        else if (strcmp(w_arg, "-shared-input") == 0) {
+            conf.shared_input = true;
+        }
+        else if (strcmp(w_arg, "-dataset") == 0) {
+            w_argc--;
+            conf.dataset_name = n_arg;
+        }
+        else if (strcmp(w_arg, "-trace") == 0) {
+            w_argc--;
+            conf.trace_prefix = n_arg;
+        }
+        else if (strcmp(w_arg, "-key") == 0) {
+            w_argc--;
+            conf.barrier_key = n_arg;
+        }
 
         
         else if (strcmp(w_arg, "-s") == 0) {
@@ -165,13 +211,18 @@ return conf;
 
 
 
-double VectorAdd(queue &q, const int *a, const int *b, int *sum, size_t size) {
+double VectorAdd(queue &q, const int *a, const int *b, int *sum, size_t size, trace_recorder &trace) {
 
   range<1> num_items{size};
+  int64_t submit = trace_recorder::now_ns();
   auto e = q.parallel_for(num_items, [=](auto i) { sum[i] = a[i] + b[i]; });
+  trace.span("submit", submit, trace_recorder::now_ns());
 
- 
+ {
+  trace_span span(trace, "wait");
   e.wait();
+ }
+  trace.device_span("VectorAdd", e, submit);
   return(e.template get_profiling_info<info::event_profiling::command_end>() -
        e.template get_profiling_info<info::event_profiling::command_start>());
 }
@@ -239,7 +290,7 @@ void InitializeArray(int *a, size_t size, bool usm) {
  * return false if data is different from benchmark
  * return true if no errors found
  */
-  bool validate (int * a, int * b, int * sum_sequential, int * data_device, size_t size)
+  bool validate (const int * a, const int * b, int * sum_sequential, int * data_device, size_t size)
   {
     //perform operation on host
     for (size_t i = 0; i < size; i++) sum_sequential[i] = a[i] + b[i];
@@ -256,8 +307,9 @@ void InitializeArray(int *a, size_t size, bool usm) {
 
   }
 
-  void omp_add (int * a, int * b, int * sum_parallel, config conf)
+  void omp_add (const int * a, const int * b, int * sum_parallel, config conf, trace_recorder *trace)
   {
+    trace_span span(*trace, "omp partition");
     int n_per_thread = conf.vector_size / conf.omp_threads;
     //std::cout<< "ele per thread, threads" << n_per_thread <<"  "<<conf.omp_threads<<std::endl;
     int i;
@@ -290,6 +342,9 @@ void benchmark(config conf)
 
 
 
+  trace_recorder trace(trace_filename(conf.trace_prefix), "multiprocess " + conf.device_str);
+  auto init_begin = trace_recorder::now_ns();
+
   try {
     queue q(selector,property::queue::enable_profiling{});
 
@@ -300,14 +355,16 @@ void benchmark(config conf)
 
     // Create arrays with "array_size" to store input and output data. Allocate
     // unified shared memory so that both CPU and device can access them.
-    int *a = malloc_shared<int>(conf.vector_size, q);
+    // with -shared-input a and b come from the shared dataset instead
+    int *a = conf.shared_input ? nullptr : malloc_shared<int>(conf.vector_size, q);
 
-    int *b = malloc_shared<int>(conf.vector_size, q);
+    int *b = conf.shared_input ? nullptr : malloc_shared<int>(conf.vector_size, q);
 
-    int *sum_sequential = malloc_shared<int>(conf.vector_size, q);
+    //only the serial check needs a fourth full size array
+    int *sum_sequential = conf.validation == validation_mode::serial ? malloc_shared<int>(conf.vector_size, q) : nullptr;
     int *sum_parallel = malloc_shared<int>(conf.vector_size, q);
 
-    if ((a == nullptr) || (b == nullptr) || (sum_sequential == nullptr) ||
+    if ((!conf.shared_input && ((a == nullptr) || (b == nullptr))) || (conf.validation == validation_mode::serial && sum_sequential == nullptr) ||
         (sum_parallel == nullptr)) {
       if (a != nullptr) free(a, q);
       if (b != nullptr) free(b, q);
@@ -319,70 +376,48 @@ void benchmark(config conf)
       exit(-1);
     }
 
+    //cpu partition reads a_host/b_host, the device a_dev/b_dev
+    const int *a_host = a, *b_host = b, *a_dev = a, *b_dev = b;
+    std::unique_ptr<shared_dataset> dataset;
+    std::unique_ptr<device_input> dev_a, dev_b;
+    auto init1 = std::chrono::steady_clock::now();
+    if(conf.shared_input)
+    {
+      dataset = std::make_unique<shared_dataset>(conf.dataset_name, conf.vector_size, conf.omp_threads);
+      a_host = dataset->a();
+      b_host = dataset->b();
+      dev_a = std::make_unique<device_input>(q, a_host, conf.vector_size);
+      dev_b = std::make_unique<device_input>(q, b_host, conf.vector_size);
+      a_dev = dev_a->get();
+      b_dev = dev_b->get();
+    }
+    else
+    {
     // Initialize input arrays with values from 0 to array_size - 1
     InitializeArray(a, conf.vector_size, true);
     InitializeArray(b, conf.vector_size, true);
+    }
+    auto init2 = std::chrono::steady_clock::now();
+    trace.span("init", init_begin, trace_recorder::now_ns());
+    std::cout << "Input " << (!conf.shared_input ? "initialized" : dataset->built_here() ? "built for all" : "mapped")
+              << " in us: " << std::chrono::duration_cast<std::chrono::microseconds>(init2 - init1).count() << std::endl;
     int i;
 
     times timer;
 //warmup RUN!
-  timer.runtime_event_ms =VectorAdd(q, a, b, sum_parallel, conf.vector_size);
+  {
+  trace_span span(trace, "warmup");
+  timer.runtime_event_ms =VectorAdd(q, a_dev, b_dev, sum_parallel, conf.vector_size, trace);
+  }
    int n_per_thread = conf.vector_size / conf.omp_threads;
 
- if(conf.write)
+  //all processes leave the barrier together, the segment goes away with the last one
+  process_barrier barrier(conf.barrier_key, conf.processes, conf.spin_us);
   {
-     std::cout <<"write process"<<std::endl;
- 
-
-// ftok to generate unique key
-
-    key_t key = ftok("shmfile", 65);
-
-     // shmat to attach to shared memory
-    size_t element_count = 5;
-    //uint64_t* data =(uint64_t*) malloc(element_count*sizeof(uint64_t));
-
-    // shmget returns an identifier in shmid
-
-    int shmid = shmget(key, 1024, 0666 | IPC_CREAT);
-
-   //int *a = malloc_shared<int>(conf.vector_size, q);
-
-    uint64_t* data = (uint64_t*)shmat(shmid, (void*)0, 0);
-
-    
-    //write start signal for experiment to reading process
-    data[0]=1;
-	
-	}
-
-else if (!conf.write)
-{
-    
-
-    std::cout <<"READ process"<<std::endl;
-
-
-     // ftok to generate unique key
-    key_t key = ftok("shmfile", 65);
-
-    // shmget returns an identifier in shmid
-    int shmid = shmget(key, 1024, 0666 | IPC_CREAT);
-
-    // shmat to attach to shared memory
-    uint64_t* data = (uint64_t*)shmat(shmid, (void*)0, 0);
-
-    while(data[0] != 1)
-    {
-       // std::cout << "Waiting for data" << std::endl;
-        std::this_thread::sleep_for(std::chrono::nanoseconds(1));
-    }
-   
-  
-  
-
-   
-}
+  trace_span span(trace, "barrier");
+  barrier.wait();
+  }
+  std::cout << "Start skew us: " << barrier.skew_us() << std::endl;
 
   std::cout << "Timer at start: " << std::chrono::high_resolution_clock::now().time_since_epoch().count() / 1000 <<std::endl;
 
@@ -396,8 +431,8 @@ else if (!conf.write)
        
         conf.processing_mode = "coprocessing";
         total1 = std::chrono::steady_clock::now();
-std::thread tt(omp_add, a,b,sum_parallel,conf);
- timer.runtime_event_ms =VectorAdd(q, a+conf.start_index, b+conf.start_index, sum_parallel+conf.start_index, conf.vector_size-conf.start_index);
+std::thread tt(omp_add, a_host,b_host,sum_parallel,conf,&trace);
+ timer.runtime_event_ms =VectorAdd(q, a_dev+conf.start_index, b_dev+conf.start_index, sum_parallel+conf.start_index, conf.vector_size-conf.start_index, trace);
    tt.join();     
    total2 = std::chrono::steady_clock::now();
  timer.runtime_chrono_ms =std::chrono::duration_cast<std::chrono::microseconds>(total2 - total1).count();
@@ -408,7 +443,7 @@ std::thread tt(omp_add, a,b,sum_parallel,conf);
       {
         conf.processing_mode = "Sycl only";
         total1 = std::chrono::steady_clock::now();
-         timer.runtime_event_ms =VectorAdd(q, a, b, sum_parallel, conf.vector_size);
+         timer.runtime_event_ms =VectorAdd(q, a_dev, b_dev, sum_parallel, conf.vector_size, trace);
          total2 = std::chrono::steady_clock::now();
          timer.runtime_chrono_ms =std::chrono::duration_cast<std::chrono::microseconds>(total2 - total1).count();
 
@@ -418,7 +453,7 @@ std::thread tt(omp_add, a,b,sum_parallel,conf);
       {
         conf.processing_mode = "OpenMP only";
           total1 = std::chrono::steady_clock::now();
-        std::thread tt(omp_add, a,b,sum_parallel,conf);
+        std::thread tt(omp_add, a_host,b_host,sum_parallel,conf,&trace);
         tt.join();     
    total2 = std::chrono::steady_clock::now();
  timer.runtime_chrono_ms =std::chrono::duration_cast<std::chrono::microseconds>(total2 - total1).count();
@@ -428,7 +463,14 @@ std::thread tt(omp_add, a,b,sum_parallel,conf);
       
 
 
-   if(!validate(a,b,sum_sequential,sum_parallel, conf.vector_size))
+   bool valid = true;
+   auto validate_begin = trace_recorder::now_ns();
+   if(conf.validation == validation_mode::serial)
+     valid = validate(a_host,b_host,sum_sequential,sum_parallel, conf.vector_size);
+   else
+     valid = validate_add(conf.validation, q, a_host, b_host, sum_parallel, conf.vector_size, conf.start_index, conf.omp_threads);
+   trace.span("validate", validate_begin, trace_recorder::now_ns());
+   if(!valid)
    {
    // return -1; //terminate benchmark without writing measurements into csv if validation fails.
    exit(-1);
@@ -461,15 +503,6 @@ int main(int argc, char* argv[]) {
     benchmark(conf);
 
 
-     std::this_thread::sleep_for(std::chrono::seconds(3));
-       // shmget returns an identifier in shmid
-
-    key_t key = ftok("shmfile", 65);
-    int shmid = shmget(key, 1024, 0666 | IPC_CREAT);
-
-    shmctl(shmid, IPC_RMID, NULL);
-
-
 
 return 0;
 }
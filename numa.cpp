@@ -0,0 +1,250 @@
+#include <sycl/sycl.hpp>
+#include <algorithm>
+#include <iostream>
+#include <map>
+#include <string>
+#include <fstream>
+#include <chrono>
+#include <vector>
+#include <unistd.h>
+#include <sys/syscall.h>
+
+
+using namespace sycl;
+
+/**
+ * Topology-aware VectorAdd on a CPU SYCL device.
+ * single: one queue on the whole device, inputs initialized by the host
+ *         thread as in compare.cpp, so all pages land on one node
+ * numa:   the device is partitioned by affinity domain numa, one queue per
+ *         sub-device; every sub-device initializes its own slice in a kernel
+ *         so first touch places the slice's pages on its node, then adds it
+ */
+struct config
+{
+ size_t vector_size =1024*256*256; //number of elements (4 byte int)
+ int repetitions =10;
+ std::string mode = "both";
+ std::string filename = "numa.csv";
+};
+
+/**
+ * -k size in KiB
+ * -m size in MiB
+ * -r repetitions
+ * -mode single, numa or both
+ * -o output filename
+ */
+config ParseInputParams (int argc, char** argv)
+{
+  config conf;
+ int w_argc = argc - 1; // remaining arg count
+    while (w_argc > 0) {
+        char* w_arg = argv[argc - (w_argc--)]; // working arg
+        char* n_arg = (w_argc > 0) ? argv[argc - w_argc] : NULL; // next arg
+
+        if (strcmp(w_arg, "-k") == 0) {
+            w_argc--;
+            conf.vector_size = 256 * std::max<size_t>(1, atol(n_arg));
+        }
+        else if (strcmp(w_arg, "-m") == 0) {
+            w_argc--;
+            conf.vector_size = 256 * 1024 * std::max<size_t>(1, atol(n_arg));
+        }
+        else if (strcmp(w_arg, "-r") == 0) {
+            w_argc--;
+            conf.repetitions = std::max(1, atoi(n_arg));
+        }
+        else if (strcmp(w_arg, "-mode") == 0) {
+            w_argc--;
+            conf.mode = n_arg;
+        }
+        else if (strcmp(w_arg, "-o") == 0) {
+            w_argc--;
+            conf.filename = n_arg;
+        }
+}
+
+return conf;
+}
+
+/**
+ * node holding most of the pages of [p, p+bytes), sampled every 64 pages.
+ * move_pages with nodes == nullptr only queries, -1 if it is not available
+ */
+int majority_node(const void *p, size_t bytes)
+{
+  long page = sysconf(_SC_PAGESIZE);
+  std::vector<void *> pages;
+  for (size_t off = 0; off < bytes; off += 64 * page) pages.push_back((char *)p + off);
+  std::vector<int> status(pages.size(), -1);
+  if (pages.empty() || syscall(SYS_move_pages, 0, pages.size(), pages.data(), nullptr, status.data(), 0) != 0)
+    return -1;
+
+  std::map<int, size_t> count;
+  for (int s : status) if (s >= 0) count[s]++;
+  int best = -1;
+  size_t best_count = 0;
+  for (auto &c : count) if (c.second > best_count) { best = c.first; best_count = c.second; }
+  return best;
+}
+
+double event_ns(event e)
+{
+  return(e.template get_profiling_info<info::event_profiling::command_end>() -
+       e.template get_profiling_info<info::event_profiling::command_start>());
+}
+
+event AddSlice(queue &q, const int *a, const int *b, int *sum, size_t begin, size_t end)
+{
+  return q.parallel_for(range<1>{end - begin}, [=](id<1> idx) {
+    size_t i = begin + idx;
+    sum[i] = a[i] + b[i];
+  });
+}
+
+event InitSlice(queue &q, int *a, int *b, int *sum, size_t begin, size_t end)
+{
+  return q.parallel_for(range<1>{end - begin}, [=](id<1> idx) {
+    size_t i = begin + idx;
+    a[i] = i;
+    b[i] = i;
+    sum[i] = 0;
+  });
+}
+
+bool validate(const int *sum, size_t size)
+{
+  for (size_t i = 0; i < size; i++)
+  {
+    if (sum[i] != (int)(2 * i))
+    {
+      std::cout << "Vector add failed at index " << i << "\n";
+      return false;
+    }
+  }
+  return true;
+}
+
+/**
+ * time all queues running their slice at once, returns wall time in us
+ * and the longest kernel in ns
+ */
+std::pair<double, double> run(std::vector<queue> &queues, const std::vector<size_t> &bounds,
+                              const int *a, const int *b, int *sum)
+{
+  std::vector<event> events;
+  auto t1 = std::chrono::steady_clock::now();
+  for (size_t k = 0; k < queues.size(); k++)
+    events.push_back(AddSlice(queues[k], a, b, sum, bounds[k], bounds[k + 1]));
+  event::wait(events);
+  auto t2 = std::chrono::steady_clock::now();
+
+  double longest = 0;
+  for (auto &e : events) longest = std::max(longest, event_ns(e));
+  return {std::chrono::duration<double, std::micro>(t2 - t1).count(), longest};
+}
+
+void report(std::ofstream &myfile, config conf, const std::string &mode, size_t queues,
+            std::pair<double, double> t)
+{
+  //two reads and one write per element
+  double gbs = 3.0 * conf.vector_size * sizeof(int) / (t.first * 1000);
+  std::cout << mode << " queues " << queues << " " << t.first / 1000 << " ms " << gbs << " GB/s" << std::endl;
+  myfile << "numa_add" << ";" << conf.vector_size
+  << ";" << mode
+  << ";" << queues
+  << ";" << t.second / 1000000 << ";" << t.first / 1000
+  << ";" << gbs
+  << std::endl;
+}
+
+int main(int argc, char* argv[]) {
+
+  config conf = ParseInputParams (argc, argv);
+  size_t n = conf.vector_size;
+
+  std::ofstream myfile(conf.filename, std::ios_base::app);
+  if (myfile.tellp() == 0)
+    myfile << "benchmark;datasize;mode;queues;time_ms_event;time_ms_chrono;gbs" << std::endl;
+
+  try {
+    device root(cpu_selector_v);
+    std::cout << "Running on device: " << root.get_info<info::device::name>() << "\n";
+
+    if (conf.mode == "single" || conf.mode == "both")
+    {
+      std::vector<queue> queues{queue(root, property::queue::enable_profiling{})};
+      int *a = malloc_shared<int>(n, queues[0]);
+      int *b = malloc_shared<int>(n, queues[0]);
+      int *sum = malloc_shared<int>(n, queues[0]);
+      if (!a || !b || !sum) { std::cout << "Shared memory allocation failure.\n"; exit(-1); }
+      for (size_t i = 0; i < n; i++) { a[i] = i; b[i] = i; sum[i] = 0; }
+      std::cout << "single: pages on node " << majority_node(a, n * sizeof(int)) << std::endl;
+
+      std::vector<size_t> bounds{0, n};
+      //warmup RUN!
+      run(queues, bounds, a, b, sum);
+      for (int r = 0; r < conf.repetitions; r++) report(myfile, conf, "single", 1, run(queues, bounds, a, b, sum));
+      if (!validate(sum, n)) exit(-1);
+
+      free(a, queues[0]);
+      free(b, queues[0]);
+      free(sum, queues[0]);
+    }
+
+    if (conf.mode == "numa" || conf.mode == "both")
+    {
+      std::vector<device> subs;
+      try {
+        subs = root.create_sub_devices<info::partition_property::partition_by_affinity_domain>(
+            info::partition_affinity_domain::numa);
+      } catch (exception const &e) {
+        std::cout << "device can not be partitioned by numa domain" << std::endl;
+        return -1;
+      }
+
+      //one context over all sub-devices so a single allocation is usable by every queue
+      context ctx(subs);
+      std::vector<queue> queues;
+      for (auto &d : subs) queues.push_back(queue(ctx, d, property::queue::enable_profiling{}));
+
+      int *a = malloc_shared<int>(n, subs[0], ctx);
+      int *b = malloc_shared<int>(n, subs[0], ctx);
+      int *sum = malloc_shared<int>(n, subs[0], ctx);
+      if (!a || !b || !sum) { std::cout << "Shared memory allocation failure.\n"; exit(-1); }
+
+      //slice per node proportional to its compute units
+      std::vector<size_t> bounds{0};
+      size_t total_cu = 0;
+      for (auto &d : subs) total_cu += d.get_info<info::device::max_compute_units>();
+      size_t acc = 0;
+      for (size_t k = 0; k < subs.size(); k++)
+      {
+        acc += subs[k].get_info<info::device::max_compute_units>();
+        bounds.push_back(k + 1 == subs.size() ? n : n * acc / total_cu);
+      }
+
+      //first touch from the sub-device that will work on the slice
+      std::vector<event> init;
+      for (size_t k = 0; k < queues.size(); k++) init.push_back(InitSlice(queues[k], a, b, sum, bounds[k], bounds[k + 1]));
+      event::wait(init);
+      for (size_t k = 0; k < queues.size(); k++)
+        std::cout << "numa: slice " << k << " [" << bounds[k] << ", " << bounds[k + 1] << ") pages on node "
+                  << majority_node(a + bounds[k], (bounds[k + 1] - bounds[k]) * sizeof(int)) << std::endl;
+
+      //warmup RUN!
+      run(queues, bounds, a, b, sum);
+      for (int r = 0; r < conf.repetitions; r++) report(myfile, conf, "numa", queues.size(), run(queues, bounds, a, b, sum));
+      if (!validate(sum, n)) exit(-1);
+
+      free(a, ctx);
+      free(b, ctx);
+      free(sum, ctx);
+    }
+  } catch (exception const &e) {
+    std::cout << "An exception is caught while adding two vectors.\n";
+    std::terminate();
+  }
+  return 0;
+}
@@ -0,0 +1,251 @@
+#include <sycl/sycl.hpp>
+#include <algorithm>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <fstream>
+#include <thread>
+#include <vector>
+#include <omp.h>
+
+#include "runtime.hpp"
+#include "elementwise.hpp"
+#include "multi_device.hpp"
+
+
+using namespace sycl;
+
+/**
+ * N-way VectorAdd: the vector is cut into one contiguous partition per
+ * target, where the targets are the OpenMP host pool and every usable SYCL
+ * device (or CPU sub-device). partition sizes follow per-target weights.
+ * every device gets its slice in its own context, copied in before and out
+ * after the timed region like the daphne input/output in usm_add.cpp.
+ */
+struct config
+{
+ size_t vector_size =1024*256*256; //number of elements (4 byte int)
+ int omp_threads =8; // 0 disables the host target
+ std::string weights = ""; //comma separated, host first, then devices in listed order
+ std::string platform_filter = "";
+ unsigned cpu_sub_devices = 0;
+ int repetitions =5;
+ bool do_validation=true;
+ std::string filename = "nway.csv";
+};
+
+/**
+ * -k size in KiB
+ * -m size in MiB
+ * -omp openmp threads int, 0 for no host partition
+ * -w weights e.g. 1,4,1 (host first), default 1 for every target
+ * -p only use platforms whose name contains this string
+ * -sub split every CPU device into this many sub-devices
+ * -r repetitions
+ * --nv no validation
+ * -o output filename
+ */
+config ParseInputParams (int argc, char** argv)
+{
+  config conf;
+ int w_argc = argc - 1; // remaining arg count
+    while (w_argc > 0) {
+        char* w_arg = argv[argc - (w_argc--)]; // working arg
+        char* n_arg = (w_argc > 0) ? argv[argc - w_argc] : NULL; // next arg
+
+        if (strcmp(w_arg, "--nv") == 0) {
+            conf.do_validation = false;
+        }
+        else if (strcmp(w_arg, "-k") == 0) {
+            w_argc--;
+            conf.vector_size = 256 * std::max<size_t>(1, atol(n_arg));
+        }
+        else if (strcmp(w_arg, "-m") == 0) {
+            w_argc--;
+            conf.vector_size = 256 * 1024 * std::max<size_t>(1, atol(n_arg));
+        }
+        else if (strcmp(w_arg, "-omp") == 0) {
+            w_argc--;
+            conf.omp_threads = std::max(0, atoi(n_arg));
+        }
+        else if (strcmp(w_arg, "-w") == 0) {
+            w_argc--;
+            conf.weights = n_arg;
+        }
+        else if (strcmp(w_arg, "-p") == 0) {
+            w_argc--;
+            conf.platform_filter = n_arg;
+        }
+        else if (strcmp(w_arg, "-sub") == 0) {
+            w_argc--;
+            conf.cpu_sub_devices = std::max(0, atoi(n_arg));
+        }
+        else if (strcmp(w_arg, "-r") == 0) {
+            w_argc--;
+            conf.repetitions = std::max(1, atoi(n_arg));
+        }
+        else if (strcmp(w_arg, "-o") == 0) {
+            w_argc--;
+            conf.filename = n_arg;
+        }
+}
+
+return conf;
+}
+
+struct target
+{
+  std::string name;
+  coprocessing_runtime::device_entry *dev = nullptr; // nullptr for the OpenMP host pool
+  float weight = 1.f;
+  size_t begin = 0;
+  size_t end = 0;
+  //slice in the device's own context
+  int *a = nullptr;
+  int *b = nullptr;
+  int *sum = nullptr;
+  double time_us = 0;
+  double event_ns = 0;
+};
+
+std::vector<float> parse_weights(const std::string &s, size_t count)
+{
+  std::vector<float> w(count, 1.f);
+  std::stringstream ss(s);
+  std::string item;
+  for (size_t t = 0; t < count && std::getline(ss, item, ','); t++) w[t] = atof(item.c_str());
+  return w;
+}
+
+/**
+ * one timed run, every device submits and waits on its own thread, the
+ * host partition runs on the calling thread. returns makespan in us
+ */
+double run(std::vector<target> &targets, const int *a, const int *b, int *sum, int omp_threads)
+{
+  auto start = std::chrono::steady_clock::now();
+  std::vector<std::thread> threads;
+  for (auto &t : targets)
+  {
+    if (t.dev == nullptr || t.end == t.begin) continue;
+    threads.emplace_back([&t, start]() {
+      event e = device_apply(t.dev->q, add_op<int>{}, t.sum, 0, t.end - t.begin, {},
+                             (const int *)t.a, (const int *)t.b);
+      e.wait();
+      t.time_us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+      t.event_ns = e.template get_profiling_info<info::event_profiling::command_end>() -
+                   e.template get_profiling_info<info::event_profiling::command_start>();
+    });
+  }
+  for (auto &t : targets)
+  {
+    if (t.dev != nullptr || t.end == t.begin) continue;
+    host_apply(omp_threads, add_op<int>{}, sum, t.begin, t.end, a, b);
+    t.time_us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+  }
+  for (auto &th : threads) th.join();
+  return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+}
+
+int main(int argc, char* argv[]) {
+
+  config conf = ParseInputParams (argc, argv);
+  size_t n = conf.vector_size;
+
+  std::vector<int> a(n), b(n), sum(n);
+  for (size_t i = 0; i < n; i++) a[i] = b[i] = i;
+
+  std::ofstream myfile(conf.filename, std::ios_base::app);
+  if (myfile.tellp() == 0)
+    myfile << "benchmark;datasize;target;weight;elements;time_ms_chrono;time_ms_event;gelem_per_s;makespan_ms" << std::endl;
+
+  try {
+    std::vector<target> targets;
+    if (conf.omp_threads > 0)
+    {
+      target host;
+      host.name = "OpenMP x" + std::to_string(conf.omp_threads);
+      targets.push_back(host);
+    }
+    for (auto &d : usable_devices(conf.platform_filter, conf.cpu_sub_devices))
+    {
+      target t;
+      t.dev = &coprocessing_runtime::instance().get(d);
+      t.name = d.get_info<info::device::name>() + " [" +
+               d.get_platform().get_info<info::platform::name>() + "]";
+      targets.push_back(t);
+    }
+    if (targets.empty())
+    {
+      std::cout << "no usable targets" << std::endl;
+      return -1;
+    }
+
+    std::vector<float> weights = parse_weights(conf.weights, targets.size());
+    auto ranges = weighted_ranges(weights, n);
+    for (size_t t = 0; t < targets.size(); t++)
+    {
+      targets[t].weight = weights[t];
+      targets[t].begin = ranges[t].first;
+      targets[t].end = ranges[t].second;
+      std::cout << "target " << t << ": " << targets[t].name << " weight " << weights[t]
+                << " elements [" << targets[t].begin << ", " << targets[t].end << ")" << std::endl;
+    }
+
+    //copy slices into each device's context
+    for (auto &t : targets)
+    {
+      if (t.dev == nullptr) continue;
+      size_t len = std::max<size_t>(1, t.end - t.begin);
+      usm_pool &pool = t.dev->pool();
+      t.a = pool.acquire<int>(len);
+      t.b = pool.acquire<int>(len);
+      t.sum = pool.acquire<int>(len);
+      if (!t.a || !t.b || !t.sum) { std::cout << "Shared memory allocation failure.\n"; exit(-1); }
+      std::copy(a.begin() + t.begin, a.begin() + t.end, t.a);
+      std::copy(b.begin() + t.begin, b.begin() + t.end, t.b);
+    }
+
+    //warmup RUN!
+    run(targets, a.data(), b.data(), sum.data(), conf.omp_threads);
+    for (int r = 0; r < conf.repetitions; r++)
+    {
+      double makespan = run(targets, a.data(), b.data(), sum.data(), conf.omp_threads);
+      std::cout << "makespan " << makespan / 1000 << " ms" << std::endl;
+      for (auto &t : targets)
+      {
+        size_t len = t.end - t.begin;
+        double gelem = t.time_us > 0 ? len / (t.time_us * 1000) : 0;
+        std::cout << "  " << t.name << " " << t.time_us / 1000 << " ms " << gelem << " Gelem/s" << std::endl;
+        myfile << "nway_add" << ";" << n
+        << ";" << t.name
+        << ";" << t.weight
+        << ";" << len
+        << ";" << t.time_us / 1000 << ";" << t.event_ns / 1000000
+        << ";" << gelem
+        << ";" << makespan / 1000
+        << std::endl;
+      }
+    }
+
+    //gather device slices into the output
+    for (auto &t : targets)
+    {
+      if (t.dev == nullptr) continue;
+      std::copy(t.sum, t.sum + (t.end - t.begin), sum.begin() + t.begin);
+      t.dev->pool().release(t.a);
+      t.dev->pool().release(t.b);
+      t.dev->pool().release(t.sum);
+    }
+
+    if (conf.do_validation && !validate_op(add_op<int>{}, sum.data(), n, (const int *)a.data(), (const int *)b.data()))
+    {
+      // return -1 if validation failed
+      exit(-1);
+    }
+  } catch (exception const &e) {
+    std::cout << "An exception is caught while adding two vectors.\n";
+    std::terminate();
+  }
+  return 0;
+}
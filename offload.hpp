@@ -0,0 +1,267 @@
+#ifndef OFFLOAD_HPP
+#define OFFLOAD_HPP
+
+#include <atomic>
+#include <chrono>
+#include <climits>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <fcntl.h>
+#include <linux/futex.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+/**
+ * Client side of the local offload daemon (offload_server.hpp). the daemon
+ * owns the device queue and USM pools, clients post requests into a ring of
+ * fixed slots in one POSIX shm object. request data never goes through the
+ * ring: it lives in a client owned shm object (offload_buffer) that the
+ * daemon maps by name, requests only carry the name and byte offsets.
+ *
+ * the ring is a bounded multi producer queue with a sequence number per slot:
+ * a client takes ticket t from tail and owns slot t % capacity once its seq
+ * is t, publishes it with seq = t + 1 and rings the doorbell. the daemon
+ * consumes tickets in order from head, fills in the result and sets done.
+ * the client copies the result out and frees the slot for ticket
+ * t + capacity. done and doorbell are futex words, both sides spin briefly
+ * before sleeping.
+ */
+
+enum class offload_op : uint32_t
+{
+  add = 1,     //out[i] = a[i] + b[i]
+  sum = 2,     //result = sum of a[i]
+  release = 3  //daemon unmaps the buffer
+};
+
+struct offload_request
+{
+  std::atomic<uint64_t> seq;
+  std::atomic<uint32_t> done;  //futex word of the waiting client
+  uint32_t op;
+  char handle[64];             //shm name of the client buffer
+  uint64_t handle_bytes;
+  uint64_t a_offset;           //byte offsets into the buffer
+  uint64_t b_offset;
+  uint64_t out_offset;
+  uint64_t elements;
+  int64_t result;
+  int32_t status;              //0 ok
+  uint32_t batch_size;         //requests that shared the launch
+  int64_t submit_ns;
+  int64_t done_ns;
+};
+
+struct offload_ring
+{
+  static constexpr uint32_t capacity = 256;
+  static constexpr uint32_t magic = 0x6f666c64; // "ofld"
+
+  std::atomic<uint32_t> ready;
+  std::atomic<int32_t> daemon_pid;  //serving process, to tell a live ring from a stale one
+  std::atomic<uint32_t> stop;
+  std::atomic<uint32_t> doorbell;   //futex word of the daemon
+  std::atomic<uint32_t> sleeping;   //daemon is in FUTEX_WAIT on doorbell
+  std::atomic<uint64_t> tail;       //next ticket for clients
+  std::atomic<uint64_t> head;       //next ticket for the daemon
+  offload_request slots[capacity];
+};
+
+//shared, not FUTEX_PRIVATE_FLAG, the words are mapped in several processes
+inline long offload_futex(std::atomic<uint32_t> *word, int op, uint32_t val, int timeout_ms = -1)
+{
+  timespec ts{timeout_ms / 1000, (timeout_ms % 1000) * 1000000L};
+  return syscall(SYS_futex, (uint32_t *)word, op, val, timeout_ms < 0 ? nullptr : &ts, nullptr, 0);
+}
+
+inline int64_t offload_now_ns()
+{
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+inline void offload_ring_init(offload_ring *r)
+{
+  r->daemon_pid.store(getpid());
+  r->stop.store(0);
+  r->doorbell.store(0);
+  r->sleeping.store(0);
+  r->tail.store(0);
+  r->head.store(0);
+  for (uint32_t i = 0; i < offload_ring::capacity; i++)
+  {
+    r->slots[i].seq.store(i);
+    r->slots[i].done.store(0);
+  }
+  r->ready.store(offload_ring::magic, std::memory_order_release);
+}
+
+/**
+ * client owned data for requests, a POSIX shm object the daemon maps by name.
+ * unlinked by the owner on destruction, a daemon mapping stays valid until
+ * the client sends release
+ */
+class offload_buffer
+{
+ public:
+  offload_buffer(const std::string &name, size_t bytes) : shm_name("/" + name), bytes(bytes)
+  {
+    int fd = shm_open(shm_name.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0666);
+    if (fd < 0 || ftruncate(fd, bytes) != 0)
+    {
+      std::cout << "offload buffer: cannot create " << shm_name << std::endl;
+      exit(-1);
+    }
+    data = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED)
+    {
+      std::cout << "offload buffer: mmap failed" << std::endl;
+      exit(-1);
+    }
+  }
+
+  ~offload_buffer()
+  {
+    munmap(data, bytes);
+    shm_unlink(shm_name.c_str());
+  }
+
+  offload_buffer(const offload_buffer &) = delete;
+  offload_buffer &operator=(const offload_buffer &) = delete;
+
+  template<typename T>
+  T *at(size_t byte_offset) const { return (T *)((char *)data + byte_offset); }
+  const std::string &name() const { return shm_name; }
+  size_t size() const { return bytes; }
+
+ private:
+  std::string shm_name;
+  size_t bytes;
+  void *data = nullptr;
+};
+
+struct offload_result
+{
+  int32_t status = -1;
+  int64_t result = 0;
+  uint32_t batch_size = 0;
+  int64_t service_ns = 0; //publish to completion, as seen by the daemon
+};
+
+class offload_client
+{
+ public:
+  //waits up to timeout_ms for the daemon to publish the ring
+  offload_client(const std::string &name, int timeout_ms = 10000, int spin_us = 50) : spin_us(spin_us)
+  {
+    std::string shm_name = "/" + name;
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout_ms);
+    int fd = -1;
+    while ((fd = shm_open(shm_name.c_str(), O_RDWR, 0666)) < 0 && std::chrono::steady_clock::now() < deadline)
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    struct stat st;
+    while (fd >= 0 && fstat(fd, &st) == 0 && (size_t)st.st_size < sizeof(offload_ring) &&
+           std::chrono::steady_clock::now() < deadline)
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    if (fd >= 0)
+    {
+      void *p = mmap(nullptr, sizeof(offload_ring), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+      close(fd);
+      if (p != MAP_FAILED) r = (offload_ring *)p;
+    }
+    while (r != nullptr && r->ready.load(std::memory_order_acquire) != offload_ring::magic &&
+           std::chrono::steady_clock::now() < deadline)
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    if (r == nullptr || r->ready.load(std::memory_order_acquire) != offload_ring::magic)
+    {
+      std::cout << "offload client: no daemon at " << shm_name << std::endl;
+      exit(-1);
+    }
+  }
+
+  ~offload_client() { munmap(r, sizeof(offload_ring)); }
+
+  offload_client(const offload_client &) = delete;
+  offload_client &operator=(const offload_client &) = delete;
+
+  //post a request, returns its ticket for wait
+  uint64_t submit(offload_op op, const offload_buffer &buf, size_t a_offset, size_t b_offset, size_t out_offset,
+                  size_t elements)
+  {
+    uint64_t t = r->tail.fetch_add(1);
+    offload_request &s = r->slots[t % offload_ring::capacity];
+    //ring full: the client of ticket t - capacity has not collected yet
+    while (s.seq.load(std::memory_order_acquire) != t) std::this_thread::yield();
+
+    s.op = (uint32_t)op;
+    strncpy(s.handle, buf.name().c_str(), sizeof(s.handle) - 1);
+    s.handle[sizeof(s.handle) - 1] = 0;
+    s.handle_bytes = buf.size();
+    s.a_offset = a_offset;
+    s.b_offset = b_offset;
+    s.out_offset = out_offset;
+    s.elements = elements;
+    s.result = 0;
+    s.status = -1;
+    s.batch_size = 0;
+    s.done.store(0, std::memory_order_relaxed);
+    s.submit_ns = offload_now_ns();
+    s.seq.store(t + 1, std::memory_order_release);
+
+    r->doorbell.fetch_add(1);
+    if (r->sleeping.load()) offload_futex(&r->doorbell, FUTEX_WAKE, 1);
+    return t;
+  }
+
+  //block until the daemon completed ticket t, then free its slot
+  offload_result wait(uint64_t t)
+  {
+    offload_request &s = r->slots[t % offload_ring::capacity];
+    auto spin_end = std::chrono::steady_clock::now() + std::chrono::microseconds(spin_us);
+    while (s.done.load(std::memory_order_acquire) == 0 && std::chrono::steady_clock::now() < spin_end)
+      ;
+    while (s.done.load(std::memory_order_acquire) == 0) offload_futex(&s.done, FUTEX_WAIT, 0, 100);
+
+    offload_result res;
+    res.status = s.status;
+    res.result = s.result;
+    res.batch_size = s.batch_size;
+    res.service_ns = s.done_ns - s.submit_ns;
+    s.seq.store(t + offload_ring::capacity, std::memory_order_release);
+    return res;
+  }
+
+  offload_result add(const offload_buffer &buf, size_t a_offset, size_t b_offset, size_t out_offset, size_t elements)
+  {
+    return wait(submit(offload_op::add, buf, a_offset, b_offset, out_offset, elements));
+  }
+
+  offload_result sum(const offload_buffer &buf, size_t a_offset, size_t elements)
+  {
+    return wait(submit(offload_op::sum, buf, a_offset, 0, 0, elements));
+  }
+
+  //daemon forgets the buffer, call before it is destroyed
+  void release(const offload_buffer &buf) { wait(submit(offload_op::release, buf, 0, 0, 0, 0)); }
+
+  //ask the daemon to finish the requests it has and exit
+  void shutdown()
+  {
+    r->stop.store(1);
+    r->doorbell.fetch_add(1);
+    offload_futex(&r->doorbell, FUTEX_WAKE, 1);
+  }
+
+ private:
+  offload_ring *r = nullptr;
+  int spin_us;
+};
+
+#endif // OFFLOAD_HPP
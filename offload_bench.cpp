@@ -0,0 +1,323 @@
+#include <sycl/sycl.hpp>
+#include <algorithm>
+#include <chrono>
+#include <climits>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "offload.hpp"
+#include "offload_server.hpp"
+#include "process_barrier.hpp"
+#include "runtime.hpp"
+
+
+using namespace sycl;
+
+/**
+ * Many client processes issuing small requests, either each through its own
+ * SYCL queue (direct) or through one offload daemon that owns the device and
+ * batches them (daemon). clients start together at a process_barrier, every
+ * request latency is kept in memory shared with the launcher. reported per
+ * mode: total throughput, latency p50/p99/p99.9 and for the daemon the
+ * launches it needed and the mean batch size.
+ * the launcher itself never touches SYCL, daemon and clients are forked.
+ */
+struct config
+{
+ int clients = 8;
+ int iterations = 1000;
+ size_t vector_size = 1024; //elements per request, 4 KiB
+ std::string op = "add"; //add or sum
+ std::string mode = "both"; //daemon, direct or both
+ std::string device_str = "gpu";
+ int max_batch = 64;
+ size_t batch_elements = 1 << 16;
+ std::string name = "offload_bench";
+ std::string barrier_key = "offload_key";
+ std::string filename = "offload.csv";
+};
+
+/**
+ * -c client processes
+ * -i requests per client
+ * -k request size in KiB
+ * -op add or sum
+ * -mode daemon, direct or both
+ * -d device sycl cpu or gpu
+ * -batch max requests the daemon takes per round
+ * -batch-k add requests up to this size in KiB are coalesced by the daemon
+ * -name shm name of the daemon ring
+ * -key barrier key file
+ * -o output filename
+ */
+config ParseInputParams (int argc, char** argv)
+{
+  config conf;
+ int w_argc = argc - 1; // remaining arg count
+    while (w_argc > 0) {
+        char* w_arg = argv[argc - (w_argc--)]; // working arg
+        char* n_arg = (w_argc > 0) ? argv[argc - w_argc] : NULL; // next arg
+
+        if (strcmp(w_arg, "-c") == 0) {
+            w_argc--;
+            conf.clients = std::max(1, atoi(n_arg));
+        }
+        else if (strcmp(w_arg, "-i") == 0) {
+            w_argc--;
+            conf.iterations = std::max(1, atoi(n_arg));
+        }
+        else if (strcmp(w_arg, "-k") == 0) {
+            w_argc--;
+            conf.vector_size = std::max(1, atoi(n_arg)) * 256;
+        }
+        else if (strcmp(w_arg, "-op") == 0) {
+            w_argc--;
+            conf.op = n_arg;
+        }
+        else if (strcmp(w_arg, "-mode") == 0) {
+            w_argc--;
+            conf.mode = n_arg;
+        }
+        else if (strcmp(w_arg, "-d") == 0) {
+            w_argc--;
+            conf.device_str = n_arg;
+        }
+        else if (strcmp(w_arg, "-batch") == 0) {
+            w_argc--;
+            conf.max_batch = std::max(1, atoi(n_arg));
+        }
+        else if (strcmp(w_arg, "-batch-k") == 0) {
+            w_argc--;
+            conf.batch_elements = (size_t)atoi(n_arg) * 256;
+        }
+        else if (strcmp(w_arg, "-name") == 0) {
+            w_argc--;
+            conf.name = n_arg;
+        }
+        else if (strcmp(w_arg, "-key") == 0) {
+            w_argc--;
+            conf.barrier_key = n_arg;
+        }
+        else if (strcmp(w_arg, "-o") == 0) {
+            w_argc--;
+            conf.filename = n_arg;
+        }
+}
+
+return conf;
+}
+
+/**
+ * results of one client in memory shared with the launcher, followed by
+ * iterations latencies in us
+ */
+struct client_slot
+{
+  int64_t start_ns = 0;
+  int64_t end_ns = 0;
+  int done = 0;
+  int failed = 0;
+  uint64_t batch_sum = 0; //sum of batch sizes seen, daemon only
+  double launch_share = 0; //sum of 1 / batch size, a launch of b requests adds up to 1
+  double latency_us[1];
+};
+
+int64_t expected_sum(size_t n) { return (int64_t)n * (n - 1) / 2; }
+
+void direct_client(config conf, int k, client_slot *slot)
+{
+  size_t n = conf.vector_size;
+  try {
+    auto &dev = coprocessing_runtime::instance().get(conf.device_str);
+    int *a = dev.pool().acquire<int>(n);
+    int *b = dev.pool().acquire<int>(n);
+    int *out = dev.pool().acquire<int>(n);
+    int64_t *result = dev.pool().acquire<int64_t>(1);
+    if (!a || !b || !out || !result) { std::cout << "Shared memory allocation failure.\n"; exit(-1); }
+    for (size_t i = 0; i < n; i++) a[i] = b[i] = i;
+
+    auto request = [&]() {
+      if (conf.op == "sum") offload_sum(dev.q, a, n, result).wait();
+      else offload_add(dev.q, a, b, out, n).wait();
+    };
+    //warmup RUN!
+    request();
+
+    process_barrier barrier(conf.barrier_key, conf.clients);
+    barrier.wait();
+    slot->start_ns = offload_now_ns();
+    for (int it = 0; it < conf.iterations; it++)
+    {
+      int64_t t0 = offload_now_ns();
+      request();
+      slot->latency_us[it] = (offload_now_ns() - t0) / 1000.0;
+      slot->done = it + 1;
+    }
+    slot->end_ns = offload_now_ns();
+
+    if (conf.op == "sum") slot->failed = *result != expected_sum(n);
+    else for (size_t i = 0; i < n; i++) if (out[i] != (int)(2 * i)) { slot->failed = 1; break; }
+  } catch (exception const &e) {
+    std::cout << "An exception is caught in client " << k << ".\n";
+    slot->failed = 1;
+  }
+}
+
+void daemon_client(config conf, int k, client_slot *slot)
+{
+  size_t n = conf.vector_size;
+  size_t bytes = n * sizeof(int);
+  offload_client client(conf.name);
+  offload_buffer buf(conf.name + "_" + std::to_string(getpid()), 3 * bytes);
+  int *a = buf.at<int>(0);
+  int *b = buf.at<int>(bytes);
+  int *out = buf.at<int>(2 * bytes);
+  for (size_t i = 0; i < n; i++) a[i] = b[i] = i;
+
+  offload_result res;
+  auto request = [&]() {
+    if (conf.op == "sum") res = client.sum(buf, 0, n);
+    else res = client.add(buf, 0, bytes, 2 * bytes, n);
+  };
+  //warmup RUN!
+  request();
+
+  process_barrier barrier(conf.barrier_key, conf.clients);
+  barrier.wait();
+  slot->start_ns = offload_now_ns();
+  for (int it = 0; it < conf.iterations; it++)
+  {
+    int64_t t0 = offload_now_ns();
+    request();
+    slot->latency_us[it] = (offload_now_ns() - t0) / 1000.0;
+    slot->batch_sum += res.batch_size;
+    slot->launch_share += 1.0 / std::max<uint32_t>(1, res.batch_size);
+    slot->done = it + 1;
+    if (res.status != 0)
+    {
+      std::cout << "daemon client " << k << ": request " << it << " failed" << std::endl;
+      slot->failed = 1;
+      break;
+    }
+  }
+  slot->end_ns = offload_now_ns();
+
+  if (conf.op == "sum") slot->failed |= res.result != expected_sum(n);
+  else for (size_t i = 0; i < n; i++) if (out[i] != (int)(2 * i)) { slot->failed = 1; break; }
+  client.release(buf);
+}
+
+double percentile(std::vector<double> &v, double p)
+{
+  std::sort(v.begin(), v.end());
+  return v.empty() ? 0 : v[std::min(v.size() - 1, (size_t)(p * v.size()))];
+}
+
+void run_mode(config conf, const std::string &mode)
+{
+  size_t slot_bytes = (sizeof(client_slot) + conf.iterations * sizeof(double) + 63) / 64 * 64;
+  size_t region = sizeof(offload_server::stats) + conf.clients * slot_bytes;
+  char *shared = (char *)mmap(nullptr, region, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+  if (shared == MAP_FAILED) { std::cout << "mmap failed\n"; exit(-1); }
+  offload_server::stats *daemon_stats = new (shared) offload_server::stats();
+  char *slots = shared + sizeof(offload_server::stats);
+
+  pid_t daemon = -1;
+  if (mode == "daemon")
+  {
+    daemon = fork();
+    if (daemon == 0)
+    {
+      try {
+        offload_server server(conf.name, conf.device_str, conf.max_batch, conf.batch_elements);
+        server.run();
+        *daemon_stats = server.get_stats();
+      } catch (exception const &e) {
+        std::cout << "An exception is caught in the offload daemon.\n";
+      }
+      _exit(0);
+    }
+  }
+
+  std::vector<pid_t> pids;
+  for (int k = 0; k < conf.clients; k++)
+  {
+    pid_t pid = fork();
+    if (pid == 0)
+    {
+      client_slot *slot = (client_slot *)(slots + k * slot_bytes);
+      if (mode == "daemon") daemon_client(conf, k, slot);
+      else direct_client(conf, k, slot);
+      _exit(0);
+    }
+    pids.push_back(pid);
+  }
+  for (pid_t pid : pids) waitpid(pid, nullptr, 0);
+
+  if (daemon > 0)
+  {
+    offload_client(conf.name).shutdown();
+    waitpid(daemon, nullptr, 0);
+  }
+
+  std::vector<double> latency;
+  double total_ops = 0, batch_sum = 0, launch_share = 0;
+  int64_t first = INT64_MAX, last = 0;
+  for (int k = 0; k < conf.clients; k++)
+  {
+    const client_slot *slot = (const client_slot *)(slots + k * slot_bytes);
+    if (slot->failed || slot->done == 0) { std::cout << mode << " client " << k << " failed" << std::endl; exit(-1); }
+    latency.insert(latency.end(), slot->latency_us, slot->latency_us + slot->done);
+    total_ops += slot->done;
+    batch_sum += slot->batch_sum;
+    launch_share += slot->launch_share;
+    first = std::min(first, slot->start_ns);
+    last = std::max(last, slot->end_ns);
+  }
+  double ops_per_s = last > first ? total_ops / ((last - first) / 1e9) : 0;
+  double p50 = percentile(latency, 0.5), p99 = percentile(latency, 0.99), p999 = percentile(latency, 0.999);
+  double mean_batch = mode == "daemon" ? batch_sum / total_ops : 1;
+  //timed requests only, like direct mode. the daemon's own count also holds
+  //the warmups, which never share a launch with timed requests
+  size_t launches = mode == "daemon" ? (size_t)std::llround(launch_share) : (size_t)total_ops;
+
+  std::cout << mode << ": " << ops_per_s << " requests/s, latency us p50 " << p50 << " p99 " << p99 << " p99.9 "
+            << p999 << ", mean batch " << mean_batch << std::endl;
+  if (mode == "daemon" && daemon_stats->staged_bytes > 0)
+    std::cout << "daemon staged " << daemon_stats->staged_bytes << " bytes, device cannot read client memory"
+              << std::endl;
+
+  std::ofstream myfile(conf.filename, std::ios_base::app);
+  if (myfile.tellp() == 0)
+    myfile << "benchmark;mode;op;datasize;clients;requests;requests_per_s;latency_us_p50;latency_us_p99;latency_us_p999;launches;mean_batch" << std::endl;
+  myfile << "offload" << ";" << mode
+  << ";" << conf.op
+  << ";" << conf.vector_size
+  << ";" << conf.clients
+  << ";" << total_ops
+  << ";" << ops_per_s
+  << ";" << p50
+  << ";" << p99
+  << ";" << p999
+  << ";" << launches
+  << ";" << mean_batch
+  << std::endl;
+
+  munmap(shared, region);
+}
+
+int main(int argc, char* argv[]) {
+
+  config conf = ParseInputParams (argc, argv);
+
+  if (conf.mode == "direct" || conf.mode == "both") run_mode(conf, "direct");
+  if (conf.mode == "daemon" || conf.mode == "both") run_mode(conf, "daemon");
+  return 0;
+}
@@ -0,0 +1,85 @@
+#include <sycl/sycl.hpp>
+#include <csignal>
+#include <cstring>
+#include <iostream>
+#include <string>
+
+#include "offload_server.hpp"
+
+
+using namespace sycl;
+
+/**
+ * Standalone offload daemon, serves clients of offload.hpp until SIGINT,
+ * SIGTERM or a client shutdown. offload_bench starts its own daemon.
+ */
+struct config
+{
+ std::string name = "offload_ring";
+ std::string device_str = "gpu";
+ int max_batch = 64;
+ size_t batch_elements = 1 << 16;
+ int spin_us = 50;
+};
+
+/**
+ * -name shm name of the request ring
+ * -d device sycl cpu or gpu
+ * -batch max requests taken from the ring per round
+ * -batch-k add requests up to this size in KiB are coalesced into one launch
+ * -spin us to spin before sleeping on the doorbell
+ */
+config ParseInputParams (int argc, char** argv)
+{
+  config conf;
+ int w_argc = argc - 1; // remaining arg count
+    while (w_argc > 0) {
+        char* w_arg = argv[argc - (w_argc--)]; // working arg
+        char* n_arg = (w_argc > 0) ? argv[argc - w_argc] : NULL; // next arg
+
+        if (strcmp(w_arg, "-name") == 0) {
+            w_argc--;
+            conf.name = n_arg;
+        }
+        else if (strcmp(w_arg, "-d") == 0) {
+            w_argc--;
+            conf.device_str = n_arg;
+        }
+        else if (strcmp(w_arg, "-batch") == 0) {
+            w_argc--;
+            conf.max_batch = std::max(1, atoi(n_arg));
+        }
+        else if (strcmp(w_arg, "-batch-k") == 0) {
+            w_argc--;
+            conf.batch_elements = (size_t)atoi(n_arg) * 256;
+        }
+        else if (strcmp(w_arg, "-spin") == 0) {
+            w_argc--;
+            conf.spin_us = std::max(0, atoi(n_arg));
+        }
+}
+
+return conf;
+}
+
+volatile std::sig_atomic_t interrupted = 0;
+
+int main(int argc, char* argv[]) {
+
+  config conf = ParseInputParams (argc, argv);
+  std::signal(SIGINT, [](int) { interrupted = 1; });
+  std::signal(SIGTERM, [](int) { interrupted = 1; });
+
+  try {
+    offload_server server(conf.name, conf.device_str, conf.max_batch, conf.batch_elements, conf.spin_us);
+    server.run(&interrupted);
+
+    auto &st = server.get_stats();
+    std::cout << "requests " << st.requests << ", launches " << st.launches << ", batched " << st.batched_requests
+              << " in " << st.batches << " launches, staged bytes " << st.staged_bytes << std::endl;
+  } catch (exception const &e) {
+    std::cout << "An exception is caught in the offload daemon.\n";
+    std::terminate();
+  }
+  return 0;
+}
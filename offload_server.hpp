@@ -0,0 +1,379 @@
+#ifndef OFFLOAD_SERVER_HPP
+#define OFFLOAD_SERVER_HPP
+
+#include <sycl/sycl.hpp>
+#include <algorithm>
+#include <cerrno>
+#include <csignal>
+#include <cstring>
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "offload.hpp"
+#include "runtime.hpp"
+
+using namespace sycl;
+
+//one add request of a batched launch, begin is its first index in the launch
+struct offload_batch_item
+{
+  const int *a;
+  const int *b;
+  int *out;
+  uint64_t begin;
+};
+
+//single add and sum launches, also used by clients that bypass the daemon
+inline event offload_add(queue &q, const int *a, const int *b, int *out, size_t n)
+{
+  return q.parallel_for(range<1>{n}, [=](id<1> i) { out[i] = a[i] + b[i]; });
+}
+
+inline event offload_sum(queue &q, const int *a, size_t n, int64_t *result)
+{
+  *result = 0;
+  return q.submit([&](handler &h) {
+    h.parallel_for(range<1>{n}, reduction(result, plus<int64_t>()), [=](id<1> i, auto &acc) { acc += a[i]; });
+  });
+}
+
+/**
+ * add requests coalesced into one launch over the concatenated index space.
+ * each work item finds its request by binary search over the begin offsets
+ */
+inline event offload_add_batch(queue &q, const offload_batch_item *items, size_t count, size_t total)
+{
+  return q.parallel_for(range<1>{total}, [=](id<1> idx) {
+    size_t i = idx;
+    size_t lo = 0, hi = count;
+    while (hi - lo > 1)
+    {
+      size_t mid = (lo + hi) / 2;
+      if (items[mid].begin <= i) lo = mid;
+      else hi = mid;
+    }
+    const offload_batch_item &it = items[lo];
+    size_t k = i - it.begin;
+    it.out[k] = it.a[k] + it.b[k];
+  });
+}
+
+/**
+ * The daemon: owns the ring, the device queue and its USM pools. it takes
+ * every published request at the head of the ring (up to max_batch), puts
+ * add requests of at most batch_elements elements into one launch, submits
+ * larger adds and sums as their own launches, waits once for all of them
+ * and completes the requests.
+ * client buffers are mapped on first use and kept until release. a device
+ * that can access system allocations works on the mappings directly, any
+ * other device gets the data staged through the shared USM pool, which is
+ * counted in staged_bytes.
+ */
+class offload_server
+{
+ public:
+  struct stats
+  {
+    size_t requests = 0;
+    size_t launches = 0;
+    size_t batched_requests = 0;   //requests that went into a batched launch
+    size_t batches = 0;
+    size_t staged_bytes = 0;
+  };
+
+  offload_server(const std::string &name, const std::string &device_str, int max_batch = 64,
+                 size_t batch_elements = 1 << 16, int spin_us = 50)
+      : shm_name("/" + name), dev(coprocessing_runtime::instance().get(device_str)), max_batch(max_batch),
+        batch_elements(batch_elements), spin_us(spin_us)
+  {
+    system_access = dev.q.get_device().has(aspect::usm_system_allocations);
+
+    //unlinking the ring of a running daemon would cut off its clients
+    pid_t owner = live_daemon(shm_name);
+    if (owner > 0)
+    {
+      std::cout << "offload daemon: " << shm_name << " is served by pid " << owner << std::endl;
+      exit(-1);
+    }
+    //a ring left behind by a daemon that did not exit cleanly is replaced
+    shm_unlink(shm_name.c_str());
+    int fd = shm_open(shm_name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0666);
+    if (fd < 0 || ftruncate(fd, sizeof(offload_ring)) != 0)
+    {
+      std::cout << "offload daemon: cannot create " << shm_name << std::endl;
+      exit(-1);
+    }
+    void *p = mmap(nullptr, sizeof(offload_ring), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (p == MAP_FAILED)
+    {
+      std::cout << "offload daemon: mmap failed" << std::endl;
+      exit(-1);
+    }
+    r = (offload_ring *)p;
+    offload_ring_init(r);
+    std::cout << "offload daemon " << shm_name << " on " << dev.q.get_device().get_info<info::device::name>()
+              << (system_access ? ", zero copy" : ", staged through USM") << std::endl;
+  }
+
+  ~offload_server()
+  {
+    for (auto &m : mappings) munmap(m.second.p, m.second.bytes);
+    r->ready.store(0);
+    munmap(r, sizeof(offload_ring));
+    shm_unlink(shm_name.c_str());
+  }
+
+  offload_server(const offload_server &) = delete;
+  offload_server &operator=(const offload_server &) = delete;
+
+  //serve until a client calls shutdown or interrupted becomes non zero
+  void run(volatile std::sig_atomic_t *interrupted = nullptr)
+  {
+    uint64_t head = r->head.load();
+    std::vector<offload_request *> batch;
+    while (!r->stop.load() && !(interrupted && *interrupted))
+    {
+      batch.clear();
+      while ((int)batch.size() < max_batch)
+      {
+        offload_request &s = r->slots[head % offload_ring::capacity];
+        if (s.seq.load(std::memory_order_acquire) != head + 1) break;
+        batch.push_back(&s);
+        head++;
+      }
+      if (batch.empty())
+      {
+        idle(head);
+        continue;
+      }
+      r->head.store(head);
+      serve(batch);
+    }
+  }
+
+  const stats &get_stats() const { return st; }
+
+ private:
+  //pid of the daemon serving an existing ring of that name, 0 if none is alive
+  static pid_t live_daemon(const std::string &shm_name)
+  {
+    int fd = shm_open(shm_name.c_str(), O_RDONLY, 0666);
+    if (fd < 0) return 0;
+    struct stat st;
+    void *p = fstat(fd, &st) == 0 && (size_t)st.st_size >= sizeof(offload_ring)
+                  ? mmap(nullptr, sizeof(offload_ring), PROT_READ, MAP_SHARED, fd, 0)
+                  : MAP_FAILED;
+    close(fd);
+    if (p == MAP_FAILED) return 0;
+    offload_ring *old = (offload_ring *)p;
+    pid_t pid = old->ready.load(std::memory_order_acquire) == offload_ring::magic ? old->daemon_pid.load() : 0;
+    munmap(p, sizeof(offload_ring));
+    //EPERM: alive, owned by another user
+    return pid > 0 && pid != getpid() && (kill(pid, 0) == 0 || errno == EPERM) ? pid : 0;
+  }
+
+  struct mapping
+  {
+    void *p;
+    size_t bytes;
+  };
+
+  struct staged
+  {
+    offload_request *req;
+    int *out_host;
+    int *out_dev;
+    size_t n;
+  };
+
+  //spin for spin_us, then sleep on the doorbell until a client posts
+  void idle(uint64_t head)
+  {
+    offload_request &s = r->slots[head % offload_ring::capacity];
+    auto spin_end = std::chrono::steady_clock::now() + std::chrono::microseconds(spin_us);
+    while (std::chrono::steady_clock::now() < spin_end)
+      if (s.seq.load(std::memory_order_acquire) == head + 1 || r->stop.load()) return;
+
+    uint32_t bell = r->doorbell.load();
+    r->sleeping.store(1);
+    if (s.seq.load(std::memory_order_acquire) != head + 1 && !r->stop.load())
+      offload_futex(&r->doorbell, FUTEX_WAIT, bell, 100);
+    r->sleeping.store(0);
+  }
+
+  char *map(offload_request &s)
+  {
+    auto it = mappings.find(s.handle);
+    if (it != mappings.end() && it->second.bytes >= s.handle_bytes) return (char *)it->second.p;
+    if (it != mappings.end())
+    {
+      munmap(it->second.p, it->second.bytes);
+      mappings.erase(it);
+    }
+    int fd = shm_open(s.handle, O_RDWR, 0666);
+    if (fd < 0) return nullptr;
+    void *p = mmap(nullptr, s.handle_bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (p == MAP_FAILED) return nullptr;
+    mappings[s.handle] = {p, s.handle_bytes};
+    return (char *)p;
+  }
+
+  void unmap(offload_request &s)
+  {
+    auto it = mappings.find(s.handle);
+    if (it == mappings.end()) return;
+    munmap(it->second.p, it->second.bytes);
+    mappings.erase(it);
+  }
+
+  //device visible copy of n ints of host memory
+  const int *stage_in(const int *host, size_t n, std::vector<void *> &held)
+  {
+    if (system_access) return host;
+    int *d = dev.pool().acquire<int>(n);
+    if (d == nullptr) return nullptr;
+    std::memcpy(d, host, n * sizeof(int));
+    held.push_back(d);
+    st.staged_bytes += n * sizeof(int);
+    return d;
+  }
+
+  int *stage_out(int *host, size_t n, std::vector<void *> &held)
+  {
+    if (system_access) return host;
+    int *d = dev.pool().acquire<int>(n);
+    if (d != nullptr) held.push_back(d);
+    return d;
+  }
+
+  void complete(offload_request &s, int status, size_t batch_size)
+  {
+    s.status = status;
+    s.batch_size = batch_size;
+    s.done_ns = offload_now_ns();
+    s.done.store(1, std::memory_order_release);
+    offload_futex(&s.done, FUTEX_WAKE, 1);
+  }
+
+  void serve(std::vector<offload_request *> &batch)
+  {
+    std::vector<offload_batch_item> small;
+    std::vector<offload_request *> small_req;
+    std::vector<offload_request *> single;
+    std::vector<staged> outputs;
+    std::vector<void *> held;
+    std::vector<int64_t *> sums;
+    size_t small_total = 0;
+    st.requests += batch.size();
+
+    for (offload_request *s : batch)
+    {
+      if (s->op == (uint32_t)offload_op::release)
+      {
+        unmap(*s);
+        complete(*s, 0, 1);
+        continue;
+      }
+      char *base = map(*s);
+      size_t n = s->elements;
+      bool in_bounds = base != nullptr && s->a_offset + n * sizeof(int) <= s->handle_bytes &&
+                       (s->op != (uint32_t)offload_op::add ||
+                        (s->b_offset + n * sizeof(int) <= s->handle_bytes &&
+                         s->out_offset + n * sizeof(int) <= s->handle_bytes));
+      if (!in_bounds || n == 0)
+      {
+        complete(*s, n == 0 && base != nullptr ? 0 : -1, 1);
+        continue;
+      }
+
+      const int *a = stage_in((const int *)(base + s->a_offset), n, held);
+      if (s->op == (uint32_t)offload_op::sum)
+      {
+        int64_t *result = a == nullptr ? nullptr : dev.pool().acquire<int64_t>(1);
+        if (result == nullptr)
+        {
+          complete(*s, -1, 1);
+          continue;
+        }
+        held.push_back(result);
+        sums.push_back(result);
+        single.push_back(s);
+        offload_sum(dev.q, a, n, result);
+        st.launches++;
+        continue;
+      }
+
+      const int *b = stage_in((const int *)(base + s->b_offset), n, held);
+      int *out_host = (int *)(base + s->out_offset);
+      int *out = stage_out(out_host, n, held);
+      if (a == nullptr || b == nullptr || out == nullptr)
+      {
+        complete(*s, -1, 1);
+        continue;
+      }
+      if (!system_access) outputs.push_back({s, out_host, out, n});
+      if (n <= batch_elements)
+      {
+        small.push_back({a, b, out, small_total});
+        small_req.push_back(s);
+        small_total += n;
+      }
+      else
+      {
+        single.push_back(s);
+        sums.push_back(nullptr);
+        offload_add(dev.q, a, b, out, n);
+        st.launches++;
+      }
+    }
+
+    offload_batch_item *items = small.empty() ? nullptr : dev.pool().acquire<offload_batch_item>(small.size());
+    if (!small.empty() && items == nullptr)
+    {
+      //nothing ran for them, their staged outputs must not be copied back
+      outputs.erase(std::remove_if(outputs.begin(), outputs.end(),
+                                   [&](const staged &o) {
+                                     return std::find(small_req.begin(), small_req.end(), o.req) != small_req.end();
+                                   }),
+                    outputs.end());
+      for (offload_request *s : small_req) complete(*s, -1, 1);
+      small_req.clear();
+    }
+    else if (!small.empty())
+    {
+      held.push_back(items);
+      std::memcpy(items, small.data(), small.size() * sizeof(offload_batch_item));
+      offload_add_batch(dev.q, items, small.size(), small_total);
+      st.launches++;
+      st.batches++;
+      st.batched_requests += small.size();
+    }
+
+    dev.q.wait();
+
+    for (auto &o : outputs) std::memcpy(o.out_host, o.out_dev, o.n * sizeof(int));
+    for (size_t i = 0; i < single.size(); i++)
+    {
+      if (sums[i] != nullptr) single[i]->result = *sums[i];
+      complete(*single[i], 0, 1);
+    }
+    for (offload_request *s : small_req) complete(*s, 0, small_req.size());
+    for (void *p : held) dev.pool().release(p);
+  }
+
+  std::string shm_name;
+  coprocessing_runtime::device_entry &dev;
+  int max_batch;
+  size_t batch_elements;
+  int spin_us;
+  bool system_access = false;
+  offload_ring *r = nullptr;
+  std::map<std::string, mapping> mappings;
+  stats st;
+};
+
+#endif // OFFLOAD_SERVER_HPP
@@ -0,0 +1,278 @@
+#include <sycl/sycl.hpp>
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <iostream>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <fstream>
+#include <thread>
+#include <vector>
+#include <omp.h>
+
+#include "runtime.hpp"
+#include "elementwise.hpp"
+
+
+using namespace sycl;
+
+/**
+ * Throughput mode: up to depth independent co-processed VectorAdds are in
+ * flight at once. the device partition of an operation is submitted without
+ * waiting, its cpu partition is queued to one host worker that runs the
+ * OpenMP loops back to back, so cpu partitions of later operations overlap
+ * device partitions of earlier ones. completions are polled and collected
+ * in whatever order they finish, and a finished slot is refilled at once.
+ */
+struct config
+{
+ size_t vector_size =1024*256; //number of elements per operation (4 byte int)
+ int omp_threads =8;
+ float share_cpu =0.5f;
+ size_t operations =1000; //operations per queue depth
+ std::string depths = "1,2,4,8,16";
+ std::string device_str = "gpu";
+ std::string filename = "pipeline.csv";
+};
+
+/**
+ * -k size in KiB per operation
+ * -m size in MiB per operation
+ * -d device sycl cpu or gpu
+ * -s share cpu factor 0..1
+ * -omp openmp threads of the host worker
+ * -n operations per queue depth
+ * -depth comma separated queue depths
+ * -o output filename
+ */
+config ParseInputParams (int argc, char** argv)
+{
+  config conf;
+ int w_argc = argc - 1; // remaining arg count
+    while (w_argc > 0) {
+        char* w_arg = argv[argc - (w_argc--)]; // working arg
+        char* n_arg = (w_argc > 0) ? argv[argc - w_argc] : NULL; // next arg
+
+        if (strcmp(w_arg, "-k") == 0) {
+            w_argc--;
+            conf.vector_size = 256 * std::max<size_t>(1, atol(n_arg));
+        }
+        else if (strcmp(w_arg, "-m") == 0) {
+            w_argc--;
+            conf.vector_size = 256 * 1024 * std::max<size_t>(1, atol(n_arg));
+        }
+        else if (strcmp(w_arg, "-d") == 0) {
+            w_argc--;
+            conf.device_str = n_arg;
+        }
+        else if (strcmp(w_arg, "-s") == 0) {
+            w_argc--;
+            conf.share_cpu = atof(n_arg);
+        }
+        else if (strcmp(w_arg, "-omp") == 0) {
+            w_argc--;
+            conf.omp_threads = std::max(1, atoi(n_arg));
+        }
+        else if (strcmp(w_arg, "-n") == 0) {
+            w_argc--;
+            conf.operations = std::max<size_t>(1, atol(n_arg));
+        }
+        else if (strcmp(w_arg, "-depth") == 0) {
+            w_argc--;
+            conf.depths = n_arg;
+        }
+        else if (strcmp(w_arg, "-o") == 0) {
+            w_argc--;
+            conf.filename = n_arg;
+        }
+}
+
+return conf;
+}
+
+//one in-flight operation with its own arrays
+struct slot
+{
+  int *a = nullptr;
+  int *b = nullptr;
+  int *sum = nullptr;
+  event e;
+  bool device_part = false;
+  std::atomic<bool> cpu_done{true};
+  std::chrono::steady_clock::time_point submitted;
+  bool busy = false;
+};
+
+/**
+ * runs the cpu partitions of all in-flight operations in submission order
+ * on one thread, each with an OpenMP team of omp_threads
+ */
+class host_worker
+{
+ public:
+  host_worker(int omp_threads) : omp_threads(omp_threads), th([this]() { loop(); }) {}
+  ~host_worker()
+  {
+    {
+      std::lock_guard<std::mutex> lock(m);
+      stop = true;
+    }
+    cv.notify_one();
+    th.join();
+  }
+
+  void push(slot *s, size_t end)
+  {
+    s->cpu_done = false;
+    {
+      std::lock_guard<std::mutex> lock(m);
+      jobs.push_back({s, end});
+    }
+    cv.notify_one();
+  }
+
+ private:
+  void loop()
+  {
+    for (;;)
+    {
+      std::pair<slot *, size_t> job;
+      {
+        std::unique_lock<std::mutex> lock(m);
+        cv.wait(lock, [this]() { return stop || !jobs.empty(); });
+        if (jobs.empty()) return;
+        job = jobs.front();
+        jobs.pop_front();
+      }
+      slot *s = job.first;
+      host_apply(omp_threads, add_op<int>{}, s->sum, 0, job.second, (const int *)s->a, (const int *)s->b);
+      s->cpu_done = true;
+    }
+  }
+
+  int omp_threads;
+  std::mutex m;
+  std::condition_variable cv;
+  std::deque<std::pair<slot *, size_t>> jobs;
+  bool stop = false;
+  std::thread th;
+};
+
+bool device_done(slot &s)
+{
+  return !s.device_part ||
+         s.e.get_info<info::event::command_execution_status>() == info::event_command_status::complete;
+}
+
+double percentile(std::vector<double> v, double p)
+{
+  std::sort(v.begin(), v.end());
+  size_t k = std::min(v.size() - 1, (size_t)(p * v.size()));
+  return v[k];
+}
+
+int main(int argc, char* argv[]) {
+
+  config conf = ParseInputParams (argc, argv);
+  size_t n = conf.vector_size;
+  coprocess_split split = make_split(n, conf.share_cpu, conf.omp_threads);
+  size_t start = std::min(split.start_index, n);
+
+  std::vector<int> depths;
+  std::stringstream ss(conf.depths);
+  std::string item;
+  while (std::getline(ss, item, ',')) depths.push_back(std::max(1, atoi(item.c_str())));
+
+  std::ofstream myfile(conf.filename, std::ios_base::app);
+  if (myfile.tellp() == 0)
+    myfile << "benchmark;datasize;device;depth;operations;ops_per_s;latency_ms_p50;latency_ms_p95;latency_ms_p99;omp_threads;cpu_share" << std::endl;
+
+  try {
+    auto &dev = coprocessing_runtime::instance().get(conf.device_str);
+    std::cout << "Running on device: "
+             << dev.q.get_device().get_info<info::device::name>() << "\n";
+    host_worker worker(conf.omp_threads);
+
+    for (int depth : depths)
+    {
+      std::vector<slot> slots(depth);
+      for (auto &s : slots)
+      {
+        s.a = dev.pool().acquire<int>(n);
+        s.b = dev.pool().acquire<int>(n);
+        s.sum = dev.pool().acquire<int>(n);
+        if (!s.a || !s.b || !s.sum) { std::cout << "Shared memory allocation failure.\n"; exit(-1); }
+        for (size_t i = 0; i < n; i++) s.a[i] = s.b[i] = i;
+      }
+
+      auto submit = [&](slot &s) {
+        s.busy = true;
+        s.submitted = std::chrono::steady_clock::now();
+        s.device_part = start < n;
+        if (s.device_part) s.e = device_apply(dev.q, add_op<int>{}, s.sum, start, n, {}, (const int *)s.a, (const int *)s.b);
+        if (start > 0) worker.push(&s, start);
+      };
+
+      //warmup RUN!
+      submit(slots[0]);
+      while (!(device_done(slots[0]) && slots[0].cpu_done)) std::this_thread::yield();
+      slots[0].busy = false;
+
+      std::vector<double> latency;
+      size_t submitted = 0, completed = 0;
+      auto t1 = std::chrono::steady_clock::now();
+      for (auto &s : slots)
+        if (submitted < conf.operations) { submit(s); submitted++; }
+
+      while (completed < conf.operations)
+      {
+        bool progress = false;
+        for (auto &s : slots)
+        {
+          if (!s.busy || !s.cpu_done || !device_done(s)) continue;
+          latency.push_back(std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - s.submitted).count());
+          s.busy = false;
+          completed++;
+          progress = true;
+          if (submitted < conf.operations) { submit(s); submitted++; }
+        }
+        if (!progress) std::this_thread::yield();
+      }
+      auto t2 = std::chrono::steady_clock::now();
+      double seconds = std::chrono::duration<double>(t2 - t1).count();
+
+      //spot check the last result of every slot
+      for (auto &s : slots)
+        for (size_t i = 0; i < n; i += std::max<size_t>(1, n / 1024))
+          if (s.sum[i] != (int)(2 * i)) { std::cout << "Vector add failed at index " << i << "\n"; exit(-1); }
+
+      double ops = conf.operations / seconds;
+      std::cout << "depth " << depth << ": " << ops << " ops/s, latency p50 " << percentile(latency, 0.5) / 1000
+                << " ms p99 " << percentile(latency, 0.99) / 1000 << " ms" << std::endl;
+      myfile << "pipeline_add" << ";" << n
+      << ";" << conf.device_str
+      << ";" << depth
+      << ";" << conf.operations
+      << ";" << ops
+      << ";" << percentile(latency, 0.5) / 1000
+      << ";" << percentile(latency, 0.95) / 1000
+      << ";" << percentile(latency, 0.99) / 1000
+      << ";" << conf.omp_threads
+      << ";" << conf.share_cpu
+      << std::endl;
+
+      for (auto &s : slots)
+      {
+        dev.pool().release(s.a);
+        dev.pool().release(s.b);
+        dev.pool().release(s.sum);
+      }
+    }
+  } catch (exception const &e) {
+    std::cout << "An exception is caught while adding two vectors.\n";
+    std::terminate();
+  }
+  return 0;
+}
@@ -7,7 +7,7 @@ struct fpvec {
 };
 
 template<typename T>
-fpvec<T> load(T* p, int i_cnt) {
+fpvec<T> load(T* p, size_t i_cnt) {
     auto reg = fpvec<T> {};
     #pragma unroll
     for (uint idx = 0; idx < 16; idx++) {
@@ -35,6 +35,23 @@ fpvec<T> add(fpvec<T>& a, fpvec<T>& b) {
   return a;
 }
 
+template<typename T>
+void store(T* p, size_t i_cnt, fpvec<T>& a) {
+    #pragma unroll
+    for (uint idx = 0; idx < 16; idx++) {
+          p[idx + i_cnt*16] = a.elements[idx];
+    }
+}
+
+template<typename T>
+fpvec<T> mul(fpvec<T>& a, T value) {
+  #pragma unroll
+  for (uint idx = 0; idx < 16; idx++) {
+          a.elements[idx] *= value;
+  }
+  return a;
+}
+
 template<typename T>
 T hadd(fpvec<T> a) {
   // Adder tree
@@ -0,0 +1,204 @@
+#ifndef PROCESS_BARRIER_HPP
+#define PROCESS_BARRIER_HPP
+
+#include <atomic>
+#include <chrono>
+#include <climits>
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <fcntl.h>
+#include <linux/futex.h>
+#include <sys/file.h>
+#include <sys/ipc.h>
+#include <sys/shm.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+/**
+ * Barrier for a fixed number of processes in a SysV shared memory segment.
+ * arrivals are counted, the last one bumps the generation counter and wakes
+ * everyone with a (non private) futex on it. waiters first spin on the
+ * generation for spin_us so a release is seen within a few microseconds,
+ * then sleep in FUTEX_WAIT. the segment is removed by the last process to
+ * detach, counted in refcount, instead of after a fixed sleep. attaching and
+ * detaching hold a flock on the key file; a segment nobody else is attached
+ * to is left over from a crashed run and replaced by a new one.
+ */
+class process_barrier
+{
+ public:
+  struct state
+  {
+    std::atomic<uint32_t> ready;        //magic once the creator has initialized
+    std::atomic<uint32_t> participants;
+    std::atomic<uint32_t> arrived;
+    std::atomic<uint32_t> generation;   //futex word
+    std::atomic<uint32_t> refcount;     //attached processes
+    std::atomic<int64_t> release_ns;    //steady_clock of the last release
+  };
+
+  static constexpr uint32_t magic = 0x62617272; // "barr"
+
+  /**
+   * key_file is created if missing, ftok needs an existing path. the first
+   * process creates and initializes the segment, later ones join it
+   */
+  process_barrier(const std::string &key_file, uint32_t participants, int spin_us = 200)
+      : key_file(key_file), spin_us(spin_us)
+  {
+    //attach, stale removal and initialization under a lock on the key file:
+    //one process at a time, so a fresh segment has a single initializer
+    int lock = lock_key_file();
+    key_t key = ftok(key_file.c_str(), 65);
+
+    bool creator = attach(key);
+    if (!creator && stale())
+    {
+      //removed once we detach, the key is free for a new segment right away
+      shmctl(shmid, IPC_RMID, nullptr);
+      shmdt(s);
+      creator = attach(key);
+    }
+
+    if (creator)
+    {
+      s->participants.store(participants);
+      s->arrived.store(0);
+      s->generation.store(0);
+      s->refcount.store(0);
+      s->release_ns.store(0);
+      s->ready.store(magic, std::memory_order_release);
+    }
+    else
+    {
+      while (s->ready.load(std::memory_order_acquire) != magic) std::this_thread::yield();
+      if (s->participants.load() != participants)
+        std::cout << "process barrier: segment expects " << s->participants.load() << " participants, not "
+                  << participants << std::endl;
+    }
+    s->refcount.fetch_add(1);
+    unlock_key_file(lock);
+  }
+
+  ~process_barrier()
+  {
+    //a process attaching meanwhile would otherwise join a removed segment
+    int lock = lock_key_file();
+    bool last = s->refcount.fetch_sub(1) == 1;
+    shmdt(s);
+    //removal takes effect once every process has detached
+    if (last) shmctl(shmid, IPC_RMID, nullptr);
+    unlock_key_file(lock);
+  }
+
+  process_barrier(const process_barrier &) = delete;
+  process_barrier &operator=(const process_barrier &) = delete;
+
+  //returns once all participants have called wait for this generation
+  void wait()
+  {
+    uint32_t gen = s->generation.load(std::memory_order_acquire);
+    if (s->arrived.fetch_add(1, std::memory_order_acq_rel) + 1 == s->participants.load())
+    {
+      s->arrived.store(0, std::memory_order_relaxed);
+      s->release_ns.store(now_ns(), std::memory_order_relaxed);
+      s->generation.fetch_add(1, std::memory_order_release);
+      futex(FUTEX_WAKE, INT_MAX);
+    }
+    else
+    {
+      auto spin_end = std::chrono::steady_clock::now() + std::chrono::microseconds(spin_us);
+      while (s->generation.load(std::memory_order_acquire) == gen && std::chrono::steady_clock::now() < spin_end)
+        cpu_relax();
+      while (s->generation.load(std::memory_order_acquire) == gen) futex(FUTEX_WAIT, gen);
+    }
+    released_ns = now_ns();
+  }
+
+  //how long after the last arrival this process left wait, in us
+  double skew_us() const { return (released_ns - s->release_ns.load()) / 1000.0; }
+
+ private:
+  //key file created if missing, ftok needs an existing path. -1 if it cannot be opened
+  int lock_key_file()
+  {
+    int fd = open(key_file.c_str(), O_CREAT | O_RDONLY, 0666);
+    if (fd >= 0) flock(fd, LOCK_EX);
+    return fd;
+  }
+
+  static void unlock_key_file(int fd)
+  {
+    if (fd < 0) return;
+    flock(fd, LOCK_UN);
+    close(fd);
+  }
+
+  //true if this call created the segment
+  bool attach(key_t key)
+  {
+    bool creator = true;
+    shmid = shmget(key, sizeof(state), 0666 | IPC_CREAT | IPC_EXCL);
+    if (shmid < 0)
+    {
+      creator = false;
+      shmid = shmget(key, sizeof(state), 0666);
+    }
+    if (shmid < 0)
+    {
+      std::cout << "process barrier: shmget failed" << std::endl;
+      exit(-1);
+    }
+    s = (state *)shmat(shmid, nullptr, 0);
+    if (s == (state *)-1)
+    {
+      std::cout << "process barrier: shmat failed" << std::endl;
+      exit(-1);
+    }
+    return creator;
+  }
+
+  /**
+   * segment left behind by a run that did not detach cleanly: we are its only
+   * attachment. every live participant attached under the key file lock, so
+   * there is no creator in between shmget and initialization
+   */
+  bool stale()
+  {
+    shmid_ds ds;
+    return shmctl(shmid, IPC_STAT, &ds) == 0 && ds.shm_nattch == 1;
+  }
+
+  static int64_t now_ns()
+  {
+    //steady_clock is CLOCK_MONOTONIC, comparable across processes on one host
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch()).count();
+  }
+
+  static void cpu_relax()
+  {
+#if defined(__x86_64__) || defined(__i386__)
+    _mm_pause();
+#endif
+  }
+
+  //shared, not FUTEX_PRIVATE_FLAG, the word is mapped in several processes
+  long futex(int op, uint32_t val)
+  {
+    return syscall(SYS_futex, (uint32_t *)&s->generation, op, val, nullptr, nullptr, 0);
+  }
+
+  std::string key_file;
+  int shmid = -1;
+  state *s = nullptr;
+  int spin_us;
+  int64_t released_ns = 0;
+};
+
+#endif // PROCESS_BARRIER_HPP
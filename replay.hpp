@@ -0,0 +1,120 @@
+#ifndef REPLAY_HPP
+#define REPLAY_HPP
+
+#include <sycl/sycl.hpp>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace sycl;
+
+/**
+ * A fixed sequence of command groups (e.g. copy -> add -> aggregate) built
+ * once and replayed every iteration. each step depends on the one before.
+ *
+ * eager:  every step is a q.submit on the caller's queue with an explicit
+ *         dependency on the previous event, what the benchmarks do today
+ * replay: with the oneAPI graph extension and a device that supports it the
+ *         steps are recorded once into an executable command graph and each
+ *         replay is a single graph submission. otherwise the pre-built
+ *         command groups are resubmitted on a private in-order queue with
+ *         discarded events, which leaves out dependency tracking and event
+ *         creation but still pays one submit per step
+ *
+ * steps capture their USM pointers and arguments by value, a replay always
+ * runs them with the values they had when recorded.
+ */
+class kernel_sequence
+{
+ public:
+  using step = std::function<void(handler &)>;
+
+  explicit kernel_sequence(queue &q)
+      : q(q), list_q(q.get_context(), q.get_device(),
+                     property_list{property::queue::in_order{},
+                                   ext::oneapi::property::queue::discard_events{}})
+  {
+  }
+
+  kernel_sequence(const kernel_sequence &) = delete;
+  kernel_sequence &operator=(const kernel_sequence &) = delete;
+
+  void add(step s) { steps.push_back(std::move(s)); }
+
+  /**
+   * build the replayable form, prefer_graph false forces the command list.
+   * returns the replay kind, "graph" or "command list"
+   */
+  const std::string &record([[maybe_unused]] bool prefer_graph = true)
+  {
+    kind = "command list";
+#ifdef SYCL_EXT_ONEAPI_GRAPH
+    //a graph of an earlier record() must not outlive a command list rerecord
+    exec.reset();
+    device d = q.get_device();
+    if (prefer_graph && (d.has(aspect::ext_oneapi_graph) || d.has(aspect::ext_oneapi_limited_graph)))
+    {
+      namespace exp = sycl::ext::oneapi::experimental;
+      //in-order recording queue, the graph edges follow the step order
+      queue record_q(q.get_context(), d, property::queue::in_order{});
+      exp::command_graph<exp::graph_state::modifiable> g(q.get_context(), d);
+      g.begin_recording(record_q);
+      for (auto &s : steps) record_q.submit(s);
+      g.end_recording(record_q);
+      exec.reset(new exp::command_graph<exp::graph_state::executable>(g.finalize()));
+      kind = "graph";
+    }
+#endif
+    recorded = true;
+    return kind;
+  }
+
+  //all steps once on the caller's queue, returns the step events
+  std::vector<event> eager()
+  {
+    std::vector<event> events;
+    event prev;
+    for (auto &s : steps)
+    {
+      prev = q.submit([&](handler &h) {
+        if (!events.empty()) h.depends_on(prev);
+        s(h);
+      });
+      events.push_back(prev);
+    }
+    prev.wait();
+    return events;
+  }
+
+  //all steps once from the recorded form, blocks until done
+  void replay()
+  {
+    if (!recorded) record();
+#ifdef SYCL_EXT_ONEAPI_GRAPH
+    if (exec)
+    {
+      q.ext_oneapi_graph(*exec).wait();
+      return;
+    }
+#endif
+    for (auto &s : steps) list_q.submit(s);
+    list_q.wait();
+  }
+
+  const std::string &replay_kind() const { return kind; }
+  size_t size() const { return steps.size(); }
+
+ private:
+  queue &q;
+  queue list_q;
+  std::vector<step> steps;
+  bool recorded = false;
+  std::string kind = "command list";
+#ifdef SYCL_EXT_ONEAPI_GRAPH
+  std::unique_ptr<sycl::ext::oneapi::experimental::command_graph<
+      sycl::ext::oneapi::experimental::graph_state::executable>> exec;
+#endif
+};
+
+#endif // REPLAY_HPP
@@ -1,15 +1,5 @@
-./mem -k 1 -o proc.csv -d gpu -omp 4 -s 0 -m 1024
-./mem -k 1 -o proc.csv -d gpu -omp 4 -s 0 -w -m 1024
-
-
-
-
-
-
-
-
-
-
-
-
-
+rm -f proc.*.trace
+./mem -k 1 -o proc.csv -d gpu -omp 4 -s 0 -m 1024 -p 2 -trace proc &
+./mem -k 1 -o proc.csv -d gpu -omp 4 -s 0 -m 1024 -p 2 -trace proc
+wait
+./trace_merge -o proc_trace.json proc.*.trace
@@ -1,45 +1 @@
-./gpuusm -m 256 -omp 1 -o omp_cpu_sycl.csv 
-./gpuusm -m 256 -omp 2 -o omp_cpu_sycl.csv 
-./gpuusm -m 256 -omp 4 -o omp_cpu_sycl.csv 
-./gpuusm -m 256 -omp 8 -o omp_cpu_sycl.csv 
-./gpuusm -m 256 -omp 16 -o omp_cpu_sycl.csv 
-./gpuusm -m 256 -omp 1 -o omp_cpu_sycl.csv 
-./gpuusm -m 256 -omp 2 -o omp_cpu_sycl.csv 
-./gpuusm -m 256 -omp 4 -o omp_cpu_sycl.csv 
-./gpuusm -m 256 -omp 8 -o omp_cpu_sycl.csv 
-./gpuusm -m 256 -omp 16 -o omp_cpu_sycl.csv 
-./gpuusm -m 1024 -omp 1 -o omp_cpu_sycl.csv 
-./gpuusm -m 1024 -omp 2 -o omp_cpu_sycl.csv 
-./gpuusm -m 1024 -omp 4 -o omp_cpu_sycl.csv 
-./gpuusm -m 1024 -omp 8 -o omp_cpu_sycl.csv 
-./gpuusm -m 1024 -omp 16 -o omp_cpu_sycl.csv 
-./gpuusm -m 1024 -omp 1 -o omp_cpu_sycl.csv 
-./gpuusm -m 1024 -omp 2 -o omp_cpu_sycl.csv 
-./gpuusm -m 1024 -omp 4 -o omp_cpu_sycl.csv 
-./gpuusm -m 1024 -omp 8 -o omp_cpu_sycl.csv 
-./gpuusm -m 1024 -omp 16 -o omp_cpu_sycl.csv 
-./gpuusm -m 2048 -omp 1 -o omp_cpu_sycl.csv 
-./gpuusm -m 2048 -omp 2 -o omp_cpu_sycl.csv 
-./gpuusm -m 2048 -omp 4 -o omp_cpu_sycl.csv 
-./gpuusm -m 2048 -omp 8 -o omp_cpu_sycl.csv 
-./gpuusm -m 2048 -omp 16 -o omp_cpu_sycl.csv 
-./gpuusm -m 2048 -omp 1 -o omp_cpu_sycl.csv 
-./gpuusm -m 2048 -omp 2 -o omp_cpu_sycl.csv 
-./gpuusm -m 2048 -omp 4 -o omp_cpu_sycl.csv 
-./gpuusm -m 2048 -omp 8 -o omp_cpu_sycl.csv 
-./gpuusm -m 2048 -omp 16 -o omp_cpu_sycl.csv 
-
-
-
-
-
-
-
-
-
-
-
-
-
-
-
+./gpuusm -sweep-m 1024 -sweep-omp 1:16 -r 6 -o omp_cpu_sycl.csv
@@ -1,9 +1 @@
-./gpuusm -o usm.csv -d gpu -s 0 -m 1024 -omp 4
-./gpuusm -o usm.csv -d gpu -s 0 -m 1024 -omp 4
-./gpuusm -o usm.csv -d gpu -s 0.25 -m 1024 -omp 4
-./gpuusm -o usm.csv -d gpu -s 0.25 -m 1024 -omp 4
-./gpuusm -o usm.csv -d gpu -s 0.75 -m 1024 -omp 4
-./gpuusm -o usm.csv -d gpu -s 0.75 -m 1024 -omp 4
-./gpuusm -o usm.csv -d gpu -s 1 -m 1024 -omp 4
-./gpuusm -o usm.csv -d gpu -s 1 -m 1024 -omp 4
-
+./gpuusm -o usm.csv -d gpu -sweep-m 1024 -sweep-s 0,0.25,0.75,1 -omp 4 -r 2
@@ -0,0 +1,218 @@
+#ifndef RUNTIME_HPP
+#define RUNTIME_HPP
+
+#include <sycl/sycl.hpp>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+using namespace sycl;
+
+// kernel name of the runtime VectorAdd
+class RuntimeVectorAddKernel;
+
+/**
+ * Pool of USM allocations of one kind (shared, host or device) for one queue.
+ * Requests are rounded up to a power-of-two size class; released blocks are
+ * kept on a free list per class and handed out again instead of calling
+ * malloc_shared/free on every benchmark invocation. If the own class is
+ * empty the smallest cached larger block of at most max_fallback_ratio times
+ * the class is used, so a sweep that acquires its largest size once serves
+ * the nearby smaller points from those blocks, while a tiny request never
+ * takes a huge block the next large request would then have to allocate.
+ */
+class usm_pool
+{
+ public:
+  static constexpr size_t min_class_bytes = 4096;
+  static constexpr size_t max_fallback_ratio = 4;
+
+  usm_pool(queue &q, usm::alloc kind = usm::alloc::shared) : q(q), kind(kind) {}
+  usm_pool(const usm_pool &) = delete;
+  usm_pool &operator=(const usm_pool &) = delete;
+  ~usm_pool() { trim(); for (auto &u : in_use) sycl::free(u.first, q); }
+
+  //round bytes up to the next size class
+  static size_t size_class(size_t bytes)
+  {
+    size_t c = min_class_bytes;
+    while (c < bytes) c <<= 1;
+    return c;
+  }
+
+  template<typename T>
+  T *acquire(size_t count)
+  {
+    return static_cast<T *>(acquire_bytes(count * sizeof(T)));
+  }
+
+  void *acquire_bytes(size_t bytes)
+  {
+    size_t c = size_class(bytes);
+    std::lock_guard<std::mutex> lock(m);
+    void *p = nullptr;
+    auto it = free_lists.lower_bound(c);
+    auto last = free_lists.upper_bound(c * max_fallback_ratio);
+    while (it != last && it->second.empty()) ++it;
+    if (it != last)
+    {
+      c = it->first;
+      p = it->second.back();
+      it->second.pop_back();
+      hits++;
+    }
+    else
+    {
+      if (kind == usm::alloc::host) p = malloc_host(c, q);
+      else if (kind == usm::alloc::device) p = malloc_device(c, q);
+      else p = malloc_shared(c, q);
+      misses++;
+      if (p == nullptr) return nullptr;
+    }
+    in_use[p] = c;
+    return p;
+  }
+
+  //return block to its size class, memory stays allocated
+  void release(void *p)
+  {
+    if (p == nullptr) return;
+    std::lock_guard<std::mutex> lock(m);
+    auto it = in_use.find(p);
+    if (it == in_use.end()) return;
+    free_lists[it->second].push_back(p);
+    in_use.erase(it);
+  }
+
+  //free all cached blocks that are not handed out
+  void trim()
+  {
+    std::lock_guard<std::mutex> lock(m);
+    for (auto &l : free_lists)
+      for (void *p : l.second) sycl::free(p, q);
+    free_lists.clear();
+  }
+
+  size_t hits = 0;
+  size_t misses = 0;
+
+ private:
+  queue &q;
+  usm::alloc kind;
+  std::mutex m;
+  std::map<size_t, std::vector<void *>> free_lists;
+  std::map<void *, size_t> in_use;
+};
+
+/**
+ * Long-lived state for repeated co-processing calls: one profiling queue per
+ * device, the pre-built executable kernel bundle for that device and a USM
+ * pool per allocation kind. Everything is created on first use and kept
+ * until process exit.
+ */
+class coprocessing_runtime
+{
+ public:
+  struct device_entry
+  {
+    queue q;
+    context ctx;
+    kernel_bundle<bundle_state::executable> bundle;
+    std::unique_ptr<usm_pool> shared_pool;
+    std::unique_ptr<usm_pool> host_pool;
+    std::unique_ptr<usm_pool> device_pool;
+
+    usm_pool &pool(usm::alloc kind = usm::alloc::shared)
+    {
+      if (kind == usm::alloc::host) return *host_pool;
+      if (kind == usm::alloc::device) return *device_pool;
+      return *shared_pool;
+    }
+  };
+
+  static coprocessing_runtime &instance()
+  {
+    static coprocessing_runtime rt;
+    return rt;
+  }
+
+  /**
+   * entry for "cpu" or "gpu" as used by conf.device_str, anything else
+   * falls back to the default selector
+   */
+  device_entry &get(const std::string &device_str)
+  {
+    std::lock_guard<std::mutex> lock(m);
+    auto it = by_name.find(device_str);
+    if (it != by_name.end()) return *it->second;
+
+    device d;
+    if (device_str == "gpu") d = device(gpu_selector_v);
+    else if (device_str == "cpu") d = device(cpu_selector_v);
+    else d = device(default_selector_v);
+
+    device_entry &e = create(d);
+    by_name[device_str] = &e;
+    return e;
+  }
+
+  //entry for an explicit device, e.g. one found by platform enumeration
+  device_entry &get(const device &d)
+  {
+    std::lock_guard<std::mutex> lock(m);
+    for (auto &e : entries)
+      if (e->q.get_device() == d) return *e;
+    return create(d);
+  }
+
+  queue &get_queue(const std::string &device_str) { return get(device_str).q; }
+
+ private:
+  coprocessing_runtime() = default;
+
+  device_entry &create(const device &d)
+  {
+    context ctx(d);
+    auto e = std::unique_ptr<device_entry>(new device_entry{
+        queue(ctx, d, property::queue::enable_profiling{}),
+        ctx,
+        // JIT/load all kernels of the program once here instead of on the
+        // first submit of each kernel
+        get_kernel_bundle<bundle_state::executable>(ctx, {d}),
+        nullptr, nullptr, nullptr});
+    e->shared_pool.reset(new usm_pool(e->q, usm::alloc::shared));
+    e->host_pool.reset(new usm_pool(e->q, usm::alloc::host));
+    e->device_pool.reset(new usm_pool(e->q, usm::alloc::device));
+    entries.push_back(std::move(e));
+    return *entries.back();
+  }
+
+  std::mutex m;
+  std::vector<std::unique_ptr<device_entry>> entries;
+  std::map<std::string, device_entry *> by_name;
+};
+
+/**
+ * VectorAdd on a runtime entry, uses the pre-built bundle so no JIT happens
+ * on the timed path. deps are events the kernel has to wait for, e.g.
+ * prefetches. returns kernel time in ns from the profiling event
+ */
+inline double VectorAdd(coprocessing_runtime::device_entry &dev,
+                        const int *a, const int *b, int *sum, size_t size,
+                        const std::vector<event> &deps = {})
+{
+  range<1> num_items{size};
+  auto e = dev.q.submit([&](handler &h) {
+    h.depends_on(deps);
+    h.use_kernel_bundle(dev.bundle);
+    h.parallel_for<RuntimeVectorAddKernel>(num_items, [=](auto i) { sum[i] = a[i] + b[i]; });
+  });
+
+  e.wait();
+  return(e.template get_profiling_info<info::event_profiling::command_end>() -
+       e.template get_profiling_info<info::event_profiling::command_start>());
+}
+
+#endif // RUNTIME_HPP
@@ -0,0 +1,161 @@
+#include <sycl/sycl.hpp>
+#include <algorithm>
+#include <iostream>
+#include <string>
+#include <fstream>
+#include <chrono>
+#include <vector>
+
+#include "runtime.hpp"
+
+
+using namespace sycl;
+
+/**
+ * First-call versus steady-state latency of one VectorAdd.
+ * cold: new queue, JIT, malloc_shared and free per call like benchmark() in usm_add.cpp
+ * first: first call through coprocessing_runtime for this size class (pool miss)
+ * steady: median over repetitions through coprocessing_runtime (pool hit, no JIT)
+ */
+struct config
+{
+ size_t min_size =256; //number of elements (4 byte int)
+ size_t max_size =1024*1024*16;
+ int repetitions =20;
+ std::string device_str = "gpu";
+ std::string filename = "runtime_latency.csv";
+};
+
+/**
+ * -min smallest vector size in elements
+ * -max largest vector size in elements
+ * -r repetitions per size
+ * -d device sycl cpu or gpu
+ * -o output filename
+ */
+config ParseInputParams (int argc, char** argv)
+{
+  config conf;
+ int w_argc = argc - 1; // remaining arg count
+    while (w_argc > 0) {
+        char* w_arg = argv[argc - (w_argc--)]; // working arg
+        char* n_arg = (w_argc > 0) ? argv[argc - w_argc] : NULL; // next arg
+
+        if (strcmp(w_arg, "-min") == 0) {
+            w_argc--;
+            conf.min_size = std::max<size_t>(1, atol(n_arg));
+        }
+        else if (strcmp(w_arg, "-max") == 0) {
+            w_argc--;
+            conf.max_size = std::max<size_t>(1, atol(n_arg));
+        }
+        else if (strcmp(w_arg, "-r") == 0) {
+            w_argc--;
+            conf.repetitions = std::max(1, atoi(n_arg));
+        }
+        else if (strcmp(w_arg, "-d") == 0) {
+            w_argc--;
+            conf.device_str = n_arg;
+        }
+        else if (strcmp(w_arg, "-o") == 0) {
+            w_argc--;
+            conf.filename = n_arg;
+        }
+}
+
+return conf;
+}
+
+double VectorAdd(queue &q, const int *a, const int *b, int *sum, size_t size) {
+
+  range<1> num_items{size};
+  auto e = q.parallel_for(num_items, [=](auto i) { sum[i] = a[i] + b[i]; });
+
+
+  e.wait();
+  return(e.template get_profiling_info<info::event_profiling::command_end>() -
+       e.template get_profiling_info<info::event_profiling::command_start>());
+}
+
+void InitializeArray(int *a, size_t size) {
+  for (size_t i = 0; i < size; i++) a[i] = i;
+}
+
+//per-call setup as done by benchmark(), returns wall time in us
+double cold_call(config conf, size_t size)
+{
+  auto t1 = std::chrono::steady_clock::now();
+  queue q(conf.device_str == "cpu" ? device(cpu_selector_v) : device(gpu_selector_v),
+          property::queue::enable_profiling{});
+  int *a = malloc_shared<int>(size, q);
+  int *b = malloc_shared<int>(size, q);
+  int *sum = malloc_shared<int>(size, q);
+  InitializeArray(a, size);
+  InitializeArray(b, size);
+  VectorAdd(q, a, b, sum, size);
+  free(a, q);
+  free(b, q);
+  free(sum, q);
+  auto t2 = std::chrono::steady_clock::now();
+  return std::chrono::duration<double, std::micro>(t2 - t1).count();
+}
+
+//same work through the long-lived runtime, returns wall time in us
+double runtime_call(config conf, size_t size)
+{
+  auto t1 = std::chrono::steady_clock::now();
+  auto &dev = coprocessing_runtime::instance().get(conf.device_str);
+  int *a = dev.pool().acquire<int>(size);
+  int *b = dev.pool().acquire<int>(size);
+  int *sum = dev.pool().acquire<int>(size);
+  InitializeArray(a, size);
+  InitializeArray(b, size);
+  VectorAdd(dev, a, b, sum, size);
+  dev.pool().release(a);
+  dev.pool().release(b);
+  dev.pool().release(sum);
+  auto t2 = std::chrono::steady_clock::now();
+  return std::chrono::duration<double, std::micro>(t2 - t1).count();
+}
+
+double median(std::vector<double> v)
+{
+  std::sort(v.begin(), v.end());
+  return v[v.size() / 2];
+}
+
+int main(int argc, char* argv[]) {
+
+  config conf = ParseInputParams (argc, argv);
+
+  std::ofstream myfile(conf.filename, std::ios_base::app);
+  if (myfile.tellp() == 0)
+    myfile << "benchmark;datasize;device;time_ms_cold;time_ms_first;time_ms_steady;repetitions" << std::endl;
+
+  try {
+    for (size_t size = conf.min_size; size <= conf.max_size; size *= 2)
+    {
+      std::vector<double> cold, steady;
+      for (int r = 0; r < conf.repetitions; r++) cold.push_back(cold_call(conf, size));
+
+      double first = runtime_call(conf, size);
+      for (int r = 0; r < conf.repetitions; r++) steady.push_back(runtime_call(conf, size));
+
+      std::cout << "size " << size << " cold " << median(cold) << " us first " << first
+                << " us steady " << median(steady) << " us" << std::endl;
+
+      myfile << "runtime_latency" << ";" << size
+      << ";" << conf.device_str
+      << ";" << median(cold) / 1000 << ";" << first / 1000 << ";" << median(steady) / 1000
+      << ";" << conf.repetitions
+      << std::endl;
+    }
+  } catch (exception const &e) {
+    std::cout << "An exception is caught while adding two vectors.\n";
+    std::terminate();
+  }
+
+  auto &pool = coprocessing_runtime::instance().get(conf.device_str).pool();
+  std::cout << "USM pool hits " << pool.hits << " misses " << pool.misses << std::endl;
+  return 0;
+}
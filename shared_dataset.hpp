@@ -0,0 +1,242 @@
+#ifndef SHARED_DATASET_HPP
+#define SHARED_DATASET_HPP
+
+#include <sycl/sycl.hpp>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace sycl;
+
+/**
+ * VectorAdd inputs a and b built once into a POSIX shm object and mapped by
+ * every process of a contention run. the first process creates the object
+ * (O_EXCL), fills a[i] = b[i] = i and publishes it; the others wait for that
+ * and map the arrays PROT_READ. only the header page with the ready flag and
+ * reference count is mapped writable; the last process to detach unlinks.
+ * every attached process holds a shared flock on the object, an object
+ * nobody holds a lock on is stale and rebuilt.
+ *
+ * layout: one header page, then a and b, each rounded up to whole pages
+ */
+class shared_dataset
+{
+ public:
+  struct header
+  {
+    std::atomic<uint32_t> ready;
+    std::atomic<uint32_t> refcount;
+    uint64_t elements;
+  };
+
+  static constexpr uint32_t magic = 0x64617461; // "data"
+
+  shared_dataset(const std::string &name, size_t elements, int omp_threads = 8)
+      : name("/" + name), elements(elements)
+  {
+    page = sysconf(_SC_PAGESIZE);
+    array_bytes = (elements * sizeof(int) + page - 1) / page * page;
+    total_bytes = page + 2 * array_bytes;
+
+    for (;;)
+    {
+      fd = shm_open(this->name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0666);
+      builder = fd >= 0;
+      if (!builder) fd = shm_open(this->name.c_str(), O_RDWR, 0666);
+      //unlinked between the two opens
+      if (fd < 0 && errno == ENOENT) continue;
+      if (fd < 0)
+      {
+        std::cout << "shared dataset: shm_open " << this->name << " failed" << std::endl;
+        exit(-1);
+      }
+      if (!builder && stale())
+      {
+        std::cout << "shared dataset: removing stale " << this->name << std::endl;
+        shm_unlink(this->name.c_str());
+        close(fd);
+        continue;
+      }
+      //held until the destructor, the kernel drops it when a process dies
+      flock(fd, LOCK_SH);
+      //removed as stale or by the last process of a finished run meanwhile
+      struct stat st;
+      if (fstat(fd, &st) == 0 && st.st_nlink == 0)
+      {
+        close(fd);
+        continue;
+      }
+      break;
+    }
+
+    if (builder)
+    {
+      if (ftruncate(fd, total_bytes) != 0)
+      {
+        std::cout << "shared dataset: ftruncate failed" << std::endl;
+        exit(-1);
+      }
+    }
+    else
+    {
+      //the builder may not have sized the object yet
+      struct stat st;
+      while (fstat(fd, &st) == 0 && (size_t)st.st_size < total_bytes)
+        std::this_thread::sleep_for(std::chrono::microseconds(100));
+    }
+
+    hdr = (header *)mmap(nullptr, page, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (hdr == MAP_FAILED)
+    {
+      std::cout << "shared dataset: mmap failed" << std::endl;
+      exit(-1);
+    }
+
+    if (builder)
+    {
+      //build through a temporary writable mapping, readers only ever see PROT_READ
+      int *w = (int *)mmap(nullptr, 2 * array_bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, page);
+      if (w == (int *)MAP_FAILED)
+      {
+        std::cout << "shared dataset: mmap failed" << std::endl;
+        exit(-1);
+      }
+      int *wa = w;
+      int *wb = (int *)((char *)w + array_bytes);
+      #pragma omp parallel for num_threads(omp_threads) schedule(static)
+      for (size_t i = 0; i < elements; i++) { wa[i] = i; wb[i] = i; }
+      munmap(w, 2 * array_bytes);
+      hdr->elements = elements;
+      //the builder is counted before publishing, else a joiner attaching and
+      //detaching first would count itself last and unlink
+      hdr->refcount.store(1);
+      hdr->ready.store(magic, std::memory_order_release);
+    }
+    else
+    {
+      while (hdr->ready.load(std::memory_order_acquire) != magic)
+        std::this_thread::sleep_for(std::chrono::microseconds(100));
+      if (hdr->elements != elements)
+      {
+        std::cout << "shared dataset: " << this->name << " holds " << hdr->elements << " elements, not "
+                  << elements << std::endl;
+        exit(-1);
+      }
+      hdr->refcount.fetch_add(1);
+    }
+
+    data = mmap(nullptr, 2 * array_bytes, PROT_READ, MAP_SHARED, fd, page);
+    if (data == MAP_FAILED)
+    {
+      std::cout << "shared dataset: mmap failed" << std::endl;
+      exit(-1);
+    }
+  }
+
+  ~shared_dataset()
+  {
+    munmap(data, 2 * array_bytes);
+    bool last = hdr->refcount.fetch_sub(1) == 1;
+    munmap(hdr, page);
+    //mappings of processes still running stay valid after the unlink. done
+    //before close so a joiner locking the object afterwards sees it unlinked
+    if (last) shm_unlink(name.c_str());
+    close(fd);
+  }
+
+  shared_dataset(const shared_dataset &) = delete;
+  shared_dataset &operator=(const shared_dataset &) = delete;
+
+  const int *a() const { return (const int *)data; }
+  const int *b() const { return (const int *)((const char *)data + array_bytes); }
+  bool built_here() const { return builder; }
+  size_t bytes() const { return total_bytes; }
+
+ private:
+  /**
+   * object left behind by a run that did not detach cleanly, e.g. one that
+   * left through exit(-1): no process holds its lock. a builder that has not
+   * taken its lock yet is given 10 ms. returns true still holding the lock
+   * exclusively, so no other process takes the object over meanwhile
+   */
+  bool stale()
+  {
+    if (flock(fd, LOCK_EX | LOCK_NB) != 0) return false;
+    uint32_t ready = 0;
+    if (pread(fd, &ready, sizeof(ready), 0) == sizeof(ready) && ready == magic) return true;
+    flock(fd, LOCK_UN);
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    return flock(fd, LOCK_EX | LOCK_NB) == 0;
+  }
+
+  std::string name;
+  size_t elements;
+  size_t page = 4096;
+  size_t array_bytes = 0;
+  size_t total_bytes = 0;
+  int fd = -1;
+  bool builder = false;
+  header *hdr = nullptr;
+  void *data = nullptr;
+};
+
+/**
+ * device view of one read-only host array. a device with system allocation
+ * support reads the mapping directly. otherwise the mapping is registered
+ * for fast transfers where the extension exists, and copied once into a
+ * device allocation
+ */
+class device_input
+{
+ public:
+  device_input(queue &q, const int *host, size_t elements) : q(q)
+  {
+    if (q.get_device().has(aspect::usm_system_allocations))
+    {
+      ptr = host;
+      return;
+    }
+#ifdef SYCL_EXT_ONEAPI_COPY_OPTIMIZE
+    sycl::ext::oneapi::experimental::prepare_for_device_copy(host, elements * sizeof(int), q);
+    registered = host;
+#endif
+    owned = malloc_device<int>(elements, q);
+    if (owned == nullptr)
+    {
+      std::cout << "Device memory allocation failure.\n";
+      exit(-1);
+    }
+    q.memcpy(owned, host, elements * sizeof(int)).wait();
+    ptr = owned;
+  }
+
+  ~device_input()
+  {
+    if (owned != nullptr) free(owned, q);
+#ifdef SYCL_EXT_ONEAPI_COPY_OPTIMIZE
+    if (registered != nullptr) sycl::ext::oneapi::experimental::release_from_device_copy(registered, q);
+#endif
+  }
+
+  device_input(const device_input &) = delete;
+  device_input &operator=(const device_input &) = delete;
+
+  const int *get() const { return ptr; }
+
+ private:
+  queue &q;
+  const int *ptr = nullptr;
+  int *owned = nullptr;
+  const void *registered = nullptr;
+};
+
+#endif // SHARED_DATASET_HPP
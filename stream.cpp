@@ -0,0 +1,302 @@
+#include <sycl/sycl.hpp>
+#include <algorithm>
+#include <iostream>
+#include <string>
+#include <fstream>
+#include <chrono>
+#include <memory>
+#include <vector>
+#include <omp.h>
+#if FPGA_HARDWARE || FPGA_EMULATOR || FPGA_SIMULATOR
+#include <sycl/ext/intel/fpga_extensions.hpp>
+#include "kernels.hpp"
+#endif
+
+#include "runtime.hpp"
+#include "elementwise.hpp"
+#include "stream.hpp"
+
+
+using namespace sycl;
+
+/**
+ * STREAM copy, scale, add and triad on int arrays for every path the
+ * co-processing benchmarks use:
+ * sycl: parallel_for on the runtime queue over shared USM, kernel time from
+ *       event profiling after a warmup that migrates the pages
+ * omp:  the OpenMP loop of the cpu partition, chrono time
+ * fpga: single_task kernels from kernels.cpp over host USM, built only with
+ *       -DFPGA_HARDWARE, -DFPGA_EMULATOR or -DFPGA_SIMULATOR
+ * the best GB/s per kernel goes into the peak file, where usm_add reads it
+ * back to report its result as a fraction of peak
+ */
+struct config
+{
+ size_t vector_size =1024*1024*64; //number of elements (4 byte int)
+ int omp_threads =8;
+ int repetitions =10;
+ std::string targets = "sycl,omp,fpga";
+ std::string device_str = "gpu";
+ std::string filename = "stream.csv";
+ std::string peak_file = "stream_peak.csv";
+};
+
+/**
+ * -k size in KiB
+ * -m size in MiB
+ * -omp openmp threads int
+ * -r repetitions per kernel, the best one is the peak
+ * -t comma separated targets sycl, omp, fpga
+ * -d device sycl cpu or gpu
+ * -o output filename
+ * -peak peak bandwidth filename
+ */
+config ParseInputParams (int argc, char** argv)
+{
+  config conf;
+ int w_argc = argc - 1; // remaining arg count
+    while (w_argc > 0) {
+        char* w_arg = argv[argc - (w_argc--)]; // working arg
+        char* n_arg = (w_argc > 0) ? argv[argc - w_argc] : NULL; // next arg
+
+        if (strcmp(w_arg, "-k") == 0) {
+            w_argc--;
+            conf.vector_size = 256 * std::max<size_t>(1, atol(n_arg));
+        }
+        else if (strcmp(w_arg, "-m") == 0) {
+            w_argc--;
+            conf.vector_size = 256 * 1024 * std::max<size_t>(1, atol(n_arg));
+        }
+        else if (strcmp(w_arg, "-omp") == 0) {
+            w_argc--;
+            conf.omp_threads = std::max(1, atoi(n_arg));
+        }
+        else if (strcmp(w_arg, "-r") == 0) {
+            w_argc--;
+            conf.repetitions = std::max(1, atoi(n_arg));
+        }
+        else if (strcmp(w_arg, "-t") == 0) {
+            w_argc--;
+            conf.targets = n_arg;
+        }
+        else if (strcmp(w_arg, "-d") == 0) {
+            w_argc--;
+            conf.device_str = n_arg;
+        }
+        else if (strcmp(w_arg, "-o") == 0) {
+            w_argc--;
+            conf.filename = n_arg;
+        }
+        else if (strcmp(w_arg, "-peak") == 0) {
+            w_argc--;
+            conf.peak_file = n_arg;
+        }
+}
+
+return conf;
+}
+
+bool has_target(config conf, const std::string &target)
+{
+  return ("," + conf.targets + ",").find("," + target + ",") != std::string::npos;
+}
+
+double event_ns(event e)
+{
+  return(e.template get_profiling_info<info::event_profiling::command_end>() -
+       e.template get_profiling_info<info::event_profiling::command_start>());
+}
+
+/**
+ * warmup plus repetitions of run, which returns the time of one kernel in
+ * ns. prints and records best and average bandwidth, returns the best
+ */
+template<typename Run>
+double measure(std::ofstream &myfile, config conf, const std::string &target, const std::string &kernel, Run run)
+{
+  double bytes = stream_bytes(kernel, conf.vector_size, sizeof(int));
+  //warmup RUN!
+  run();
+  double best_ns = 0, total_ns = 0;
+  for (int r = 0; r < conf.repetitions; r++)
+  {
+    double ns = run();
+    total_ns += ns;
+    if (r == 0 || ns < best_ns) best_ns = ns;
+  }
+  double best_gbs = bytes / best_ns;
+  double avg_gbs = bytes / (total_ns / conf.repetitions);
+  std::cout << target << " " << kernel << ": best " << best_gbs << " GB/s, avg " << avg_gbs << " GB/s" << std::endl;
+  myfile << "stream_" << kernel << ";" << conf.vector_size
+  << ";" << conf.device_str
+  << ";" << target
+  << ";" << best_ns / 1000000
+  << ";" << best_gbs
+  << ";" << avg_gbs
+  << ";" << conf.omp_threads
+  << std::endl;
+  return best_gbs;
+}
+
+template<typename Op, typename... In>
+void check(Op op, int *out, size_t size, const In *...in)
+{
+  if (!validate_op(op, out, size, in...)) exit(-1);
+}
+
+void run_sycl(std::ofstream &myfile, config conf, peak_store &peaks)
+{
+  auto &dev = coprocessing_runtime::instance().get(conf.device_str);
+  queue &q = dev.q;
+  std::string name = q.get_device().get_info<info::device::name>();
+  std::cout << "Running on device: " << name << "\n";
+  size_t n = conf.vector_size;
+
+  int *a = dev.pool().acquire<int>(n);
+  int *b = dev.pool().acquire<int>(n);
+  int *c = dev.pool().acquire<int>(n);
+  if (!a || !b || !c) { std::cout << "Shared memory allocation failure.\n"; exit(-1); }
+  for (size_t i = 0; i < n; i++) { a[i] = i % 1000; b[i] = i % 7; c[i] = 0; }
+
+  double gbs;
+  gbs = measure(myfile, conf, "sycl", "copy", [&]() {
+    event e = device_apply(q, copy_op<int>{}, c, 0, n, {}, (const int *)a); e.wait(); return event_ns(e); });
+  check(copy_op<int>{}, c, n, (const int *)a);
+  peaks.put(name, "sycl", "copy", gbs);
+
+  gbs = measure(myfile, conf, "sycl", "scale", [&]() {
+    event e = device_apply(q, scale_op<int>{3}, b, 0, n, {}, (const int *)c); e.wait(); return event_ns(e); });
+  check(scale_op<int>{3}, b, n, (const int *)c);
+  peaks.put(name, "sycl", "scale", gbs);
+
+  gbs = measure(myfile, conf, "sycl", "add", [&]() {
+    event e = device_apply(q, add_op<int>{}, c, 0, n, {}, (const int *)a, (const int *)b); e.wait(); return event_ns(e); });
+  check(add_op<int>{}, c, n, (const int *)a, (const int *)b);
+  peaks.put(name, "sycl", "add", gbs);
+
+  gbs = measure(myfile, conf, "sycl", "triad", [&]() {
+    event e = device_apply(q, triad_op<int>{3}, a, 0, n, {}, (const int *)b, (const int *)c); e.wait(); return event_ns(e); });
+  check(triad_op<int>{3}, a, n, (const int *)b, (const int *)c);
+  peaks.put(name, "sycl", "triad", gbs);
+
+  dev.pool().release(a);
+  dev.pool().release(b);
+  dev.pool().release(c);
+}
+
+void run_omp(std::ofstream &myfile, config conf, peak_store &peaks)
+{
+  size_t n = conf.vector_size;
+  int threads = conf.omp_threads;
+  std::string target = "omp" + std::to_string(threads);
+  //uninitialized, so the first touch below places the pages
+  std::unique_ptr<int[]> va(new int[n]), vb(new int[n]), vc(new int[n]);
+  int *a = va.get(), *b = vb.get(), *c = vc.get();
+
+  //first touch by the team that runs the kernels
+  #pragma omp parallel for num_threads(threads) schedule(static)
+  for (size_t i = 0; i < n; i++) { a[i] = i % 1000; b[i] = i % 7; c[i] = 0; }
+
+  auto chrono_ns = [](auto f) {
+    auto t1 = std::chrono::steady_clock::now();
+    f();
+    return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - t1).count();
+  };
+
+  double gbs;
+  gbs = measure(myfile, conf, "omp", "copy", [&]() {
+    return chrono_ns([&]() { host_apply(threads, copy_op<int>{}, c, 0, n, (const int *)a); }); });
+  check(copy_op<int>{}, c, n, (const int *)a);
+  peaks.put("host", target, "copy", gbs);
+
+  gbs = measure(myfile, conf, "omp", "scale", [&]() {
+    return chrono_ns([&]() { host_apply(threads, scale_op<int>{3}, b, 0, n, (const int *)c); }); });
+  check(scale_op<int>{3}, b, n, (const int *)c);
+  peaks.put("host", target, "scale", gbs);
+
+  gbs = measure(myfile, conf, "omp", "add", [&]() {
+    return chrono_ns([&]() { host_apply(threads, add_op<int>{}, c, 0, n, (const int *)a, (const int *)b); }); });
+  check(add_op<int>{}, c, n, (const int *)a, (const int *)b);
+  peaks.put("host", target, "add", gbs);
+
+  gbs = measure(myfile, conf, "omp", "triad", [&]() {
+    return chrono_ns([&]() { host_apply(threads, triad_op<int>{3}, a, 0, n, (const int *)b, (const int *)c); }); });
+  check(triad_op<int>{3}, a, n, (const int *)b, (const int *)c);
+  peaks.put("host", target, "triad", gbs);
+}
+
+#if FPGA_HARDWARE || FPGA_EMULATOR || FPGA_SIMULATOR
+void run_fpga(std::ofstream &myfile, config conf, peak_store &peaks)
+{
+#if FPGA_SIMULATOR
+  auto selector = sycl::ext::intel::fpga_simulator_selector_v;
+#elif FPGA_HARDWARE
+  auto selector = sycl::ext::intel::fpga_selector_v;
+#else
+  auto selector = sycl::ext::intel::fpga_emulator_selector_v;
+#endif
+  queue q(selector, property::queue::enable_profiling{});
+  std::string name = q.get_device().get_info<info::device::name>();
+  std::cout << "Running on device: " << name << "\n";
+
+  //whole 512-bit lines only
+  conf.vector_size = conf.vector_size / 16 * 16;
+  size_t n = conf.vector_size;
+  int *a = malloc_host<int>(n, q);
+  int *b = malloc_host<int>(n, q);
+  int *c = malloc_host<int>(n, q);
+  if (!a || !b || !c) { std::cout << "Host memory allocation failure.\n"; exit(-1); }
+  for (size_t i = 0; i < n; i++) { a[i] = i % 1000; b[i] = i % 7; c[i] = 0; }
+
+  auto chrono_ns = [](auto f) {
+    auto t1 = std::chrono::steady_clock::now();
+    f();
+    return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - t1).count();
+  };
+
+  double gbs;
+  gbs = measure(myfile, conf, "fpga", "copy", [&]() { return chrono_ns([&]() { stream_copy_kernel(q, a, c, n); }); });
+  check(copy_op<int>{}, c, n, (const int *)a);
+  peaks.put(name, "fpga", "copy", gbs);
+
+  gbs = measure(myfile, conf, "fpga", "scale", [&]() { return chrono_ns([&]() { stream_scale_kernel(q, c, b, 3, n); }); });
+  check(scale_op<int>{3}, b, n, (const int *)c);
+  peaks.put(name, "fpga", "scale", gbs);
+
+  gbs = measure(myfile, conf, "fpga", "add", [&]() { return chrono_ns([&]() { stream_add_kernel(q, a, b, c, n); }); });
+  check(add_op<int>{}, c, n, (const int *)a, (const int *)b);
+  peaks.put(name, "fpga", "add", gbs);
+
+  gbs = measure(myfile, conf, "fpga", "triad", [&]() { return chrono_ns([&]() { stream_triad_kernel(q, a, b, c, 3, n); }); });
+  check(triad_op<int>{3}, a, n, (const int *)b, (const int *)c);
+  peaks.put(name, "fpga", "triad", gbs);
+
+  free(a, q);
+  free(b, q);
+  free(c, q);
+}
+#endif
+
+int main(int argc, char* argv[]) {
+
+  config conf = ParseInputParams (argc, argv);
+  peak_store peaks(conf.peak_file);
+
+  std::ofstream myfile(conf.filename, std::ios_base::app);
+  if (myfile.tellp() == 0)
+    myfile << "benchmark;datasize;device;target;time_ms_best;gbs_best;gbs_avg;omp_threads" << std::endl;
+
+  try {
+    if (has_target(conf, "sycl")) run_sycl(myfile, conf, peaks);
+    if (has_target(conf, "omp")) run_omp(myfile, conf, peaks);
+#if FPGA_HARDWARE || FPGA_EMULATOR || FPGA_SIMULATOR
+    if (has_target(conf, "fpga")) run_fpga(myfile, conf, peaks);
+#else
+    if (has_target(conf, "fpga")) std::cout << "fpga target skipped, build with -DFPGA_HARDWARE or -DFPGA_EMULATOR" << std::endl;
+#endif
+  } catch (exception const &e) {
+    std::cout << "An exception is caught while running the stream kernels.\n";
+    std::terminate();
+  }
+  return 0;
+}
@@ -0,0 +1,122 @@
+#ifndef STREAM_HPP
+#define STREAM_HPP
+
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+/**
+ * STREAM byte counting: arrays read plus arrays written per element, no
+ * write allocate traffic. copy and scale move 2 words, add and triad 3
+ */
+inline double stream_bytes(const std::string &kernel, size_t elements, size_t word)
+{
+  int arrays = (kernel == "add" || kernel == "triad") ? 3 : 2;
+  return (double)arrays * elements * word;
+}
+
+/**
+ * best measured bandwidth per device, target and kernel, one line each:
+ * device_name;target;kernel;gbs
+ * target is sycl, omp or fpga. written by stream, read by the co-processing
+ * benchmarks to report their result as a fraction of peak
+ */
+class peak_store
+{
+ public:
+  explicit peak_store(std::string filename) : filename(filename) { load(); }
+
+  //0 if the kernel was not measured for this device and target
+  double find(const std::string &device_name, const std::string &target, const std::string &kernel) const
+  {
+    auto it = peaks.find(device_name + ";" + target + ";" + kernel);
+    return it == peaks.end() ? 0 : it->second;
+  }
+
+  //keeps the better of the stored and the new value
+  void put(const std::string &device_name, const std::string &target, const std::string &kernel, double gbs)
+  {
+    double &p = peaks[device_name + ";" + target + ";" + kernel];
+    p = std::max(p, gbs);
+    save();
+  }
+
+ private:
+  void load()
+  {
+    std::ifstream in(filename);
+    std::string line;
+    while (std::getline(in, line))
+    {
+      size_t last = line.rfind(';');
+      if (last == std::string::npos) continue;
+      peaks[line.substr(0, last)] = std::stod(line.substr(last + 1));
+    }
+  }
+
+  void save() const
+  {
+    std::ofstream out(filename, std::ios_base::trunc);
+    for (auto &p : peaks) out << p.first << ";" << p.second << std::endl;
+  }
+
+  std::string filename;
+  std::map<std::string, double> peaks;
+};
+
+/**
+ * roofline of one co-processed operation: with the cpu streaming its share
+ * at omp_gbs and the device the rest at sycl_gbs, the best makespan is the
+ * slower of the two, so the attainable bandwidth is bytes / that makespan.
+ * 0 if a needed peak is missing
+ */
+inline double coprocess_peak_gbs(double bytes, double share_cpu, double omp_gbs, double sycl_gbs)
+{
+  double cpu_bytes = bytes * share_cpu;
+  double dev_bytes = bytes - cpu_bytes;
+  if ((cpu_bytes > 0 && omp_gbs <= 0) || (dev_bytes > 0 && sycl_gbs <= 0)) return 0;
+  double t_cpu = cpu_bytes > 0 ? cpu_bytes / omp_gbs : 0;
+  double t_dev = dev_bytes > 0 ? dev_bytes / sycl_gbs : 0;
+  double t = std::max(t_cpu, t_dev);
+  return t > 0 ? bytes / t : 0;
+}
+
+constexpr const char *roofline_header = "benchmark;datasize;device;mode;gbs;peak_gbs;peak_fraction";
+
+/**
+ * print achieved against attainable bandwidth and write it as one row of
+ * roofline_header to out, e.g. a buffer a sweep writes out once at the end
+ */
+inline void report_roofline(std::ostream &myfile, const std::string &benchmark, size_t elements,
+                            const std::string &device, const std::string &mode, double gbs, double peak_gbs)
+{
+  double fraction = peak_gbs > 0 ? gbs / peak_gbs : 0;
+  if (peak_gbs > 0)
+    std::cout << mode << ": " << gbs << " GB/s, " << fraction * 100 << " % of measured peak " << peak_gbs
+              << " GB/s" << std::endl;
+  else
+    std::cout << mode << ": " << gbs << " GB/s, no measured peak, run stream first" << std::endl;
+
+  myfile << benchmark << ";" << elements
+  << ";" << device
+  << ";" << mode
+  << ";" << gbs
+  << ";" << peak_gbs
+  << ";" << fraction
+  << std::endl;
+}
+
+//the same, appended to filename
+inline void report_roofline(const std::string &filename, const std::string &benchmark, size_t elements,
+                            const std::string &device, const std::string &mode, double gbs, double peak_gbs)
+{
+  std::ofstream myfile(filename, std::ios_base::app);
+  if (myfile.tellp() == 0) myfile << roofline_header << std::endl;
+  report_roofline(myfile, benchmark, elements, device, mode, gbs, peak_gbs);
+}
+
+#endif // STREAM_HPP
@@ -0,0 +1,136 @@
+#ifndef TRACE_HPP
+#define TRACE_HPP
+
+#include <sycl/sycl.hpp>
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+using namespace sycl;
+
+/**
+ * Per-process timeline for the Chrome trace / Perfetto viewer. host spans are
+ * taken on steady_clock (CLOCK_MONOTONIC), which is the same clock in every
+ * process on one host, so files of concurrent processes line up without any
+ * exchange. SYCL event timestamps come from the device clock and are moved
+ * onto that clock through the submit time: the host time just before the
+ * submit is taken as the event's command_submit.
+ *
+ * events are buffered and written on destruction, one per line:
+ * ph;pid;tid;ts_ns;dur_ns;cat;name
+ * trace_merge turns any number of these files into one trace JSON.
+ * a recorder built with an empty filename records nothing.
+ */
+class trace_recorder
+{
+ public:
+  trace_recorder(const std::string &filename, const std::string &process_name)
+      : filename(filename), pid(getpid())
+  {
+    if (enabled()) events.push_back({'M', 0, 0, 0, "process_name", process_name});
+  }
+
+  ~trace_recorder() { flush(); }
+
+  trace_recorder(const trace_recorder &) = delete;
+  trace_recorder &operator=(const trace_recorder &) = delete;
+
+  bool enabled() const { return !filename.empty(); }
+
+  static int64_t now_ns()
+  {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch()).count();
+  }
+
+  //host span on the calling thread
+  void span(const std::string &name, int64_t begin_ns, int64_t end_ns, const std::string &cat = "host")
+  {
+    if (!enabled()) return;
+    std::lock_guard<std::mutex> lock(m);
+    events.push_back({'X', (long)syscall(SYS_gettid), begin_ns, end_ns - begin_ns, cat, name});
+  }
+
+  /**
+   * device execution of a completed event. the queue needs enable_profiling.
+   * shown on its own track, tid -1, so overlapping host spans stay readable
+   */
+  void device_span(const std::string &name, event &e, int64_t host_submit_ns)
+  {
+    if (!enabled()) return;
+    int64_t submit = e.get_profiling_info<info::event_profiling::command_submit>();
+    int64_t start = e.get_profiling_info<info::event_profiling::command_start>();
+    int64_t end = e.get_profiling_info<info::event_profiling::command_end>();
+    std::lock_guard<std::mutex> lock(m);
+    events.push_back({'X', -1, host_submit_ns + (start - submit), end - start, "device", name});
+  }
+
+  //write everything recorded so far
+  void flush()
+  {
+    if (!enabled()) return;
+    std::lock_guard<std::mutex> lock(m);
+    if (events.empty()) return;
+    //the file is per pid, a rerun must not append to an old one
+    std::ofstream out(filename, written ? std::ios_base::app : std::ios_base::trunc);
+    if (!out)
+    {
+      std::cout << "trace: cannot write " << filename << std::endl;
+      return;
+    }
+    for (auto &e : events)
+      out << e.ph << ";" << pid << ";" << e.tid << ";" << e.ts_ns << ";" << e.dur_ns << ";" << e.cat << ";"
+          << e.name << std::endl;
+    events.clear();
+    written = true;
+  }
+
+ private:
+  struct trace_event
+  {
+    char ph;
+    long tid;
+    int64_t ts_ns;
+    int64_t dur_ns;
+    std::string cat;
+    std::string name;
+  };
+
+  std::string filename;
+  pid_t pid;
+  std::mutex m;
+  std::vector<trace_event> events;
+  bool written = false;
+};
+
+/**
+ * RAII host span, records from construction to destruction
+ */
+class trace_span
+{
+ public:
+  trace_span(trace_recorder &t, const std::string &name) : t(t), name(name), begin(trace_recorder::now_ns()) {}
+  ~trace_span() { t.span(name, begin, trace_recorder::now_ns()); }
+
+  trace_span(const trace_span &) = delete;
+  trace_span &operator=(const trace_span &) = delete;
+
+ private:
+  trace_recorder &t;
+  std::string name;
+  int64_t begin;
+};
+
+//file of one process for a trace prefix, empty prefix disables tracing
+inline std::string trace_filename(const std::string &prefix)
+{
+  return prefix.empty() ? "" : prefix + "." + std::to_string(getpid()) + ".trace";
+}
+
+#endif // TRACE_HPP
@@ -0,0 +1,156 @@
+#include <algorithm>
+#include <climits>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+/**
+ * Merge the per-process files written by trace_recorder (trace.hpp) into one
+ * Chrome trace JSON for chrome://tracing or ui.perfetto.dev. all processes
+ * already share the steady_clock, timestamps are only shifted so the
+ * earliest event starts at 0 and converted to us.
+ * device spans (tid -1) get their own named track per process.
+ */
+struct config
+{
+ std::string filename = "trace.json";
+ std::vector<std::string> inputs;
+};
+
+/**
+ * -o output filename
+ * every other argument is an input trace file
+ */
+config ParseInputParams (int argc, char** argv)
+{
+  config conf;
+ int w_argc = argc - 1; // remaining arg count
+    while (w_argc > 0) {
+        char* w_arg = argv[argc - (w_argc--)]; // working arg
+        char* n_arg = (w_argc > 0) ? argv[argc - w_argc] : NULL; // next arg
+
+        if (strcmp(w_arg, "-o") == 0 && n_arg != NULL) {
+            w_argc--;
+            conf.filename = n_arg;
+        }
+        else {
+            conf.inputs.push_back(w_arg);
+        }
+}
+
+return conf;
+}
+
+struct trace_event
+{
+  char ph;
+  long pid;
+  long tid;
+  long long ts_ns;
+  long long dur_ns;
+  std::string cat;
+  std::string name;
+};
+
+//names are written by the benchmarks, only quotes and backslashes need escaping
+std::string escape(const std::string &s)
+{
+  std::string r;
+  for (char c : s)
+  {
+    if (c == '"' || c == '\\') r += '\\';
+    r += c;
+  }
+  return r;
+}
+
+bool parse(const std::string &line, trace_event &e)
+{
+  std::stringstream ss(line);
+  std::string f[7];
+  for (int i = 0; i < 6; i++)
+    if (!std::getline(ss, f[i], ';')) return false;
+  //the name may contain ';'
+  std::getline(ss, f[6]);
+  try {
+    e.ph = f[0].empty() ? 'X' : f[0][0];
+    e.pid = std::stol(f[1]);
+    e.tid = std::stol(f[2]);
+    e.ts_ns = std::stoll(f[3]);
+    e.dur_ns = std::stoll(f[4]);
+  } catch (std::exception const &) {
+    return false;
+  }
+  e.cat = f[5];
+  e.name = f[6];
+  return true;
+}
+
+int main(int argc, char* argv[]) {
+
+  config conf = ParseInputParams (argc, argv);
+  if (conf.inputs.empty())
+  {
+    std::cout << "usage: trace_merge [-o trace.json] process.trace ..." << std::endl;
+    return -1;
+  }
+
+  std::vector<trace_event> events;
+  for (auto &input : conf.inputs)
+  {
+    std::ifstream in(input);
+    if (!in) { std::cout << "cannot read " << input << std::endl; return -1; }
+    std::string line;
+    int skipped = 0;
+    while (std::getline(in, line))
+    {
+      trace_event e;
+      if (parse(line, e)) events.push_back(e);
+      else if (!line.empty()) skipped++;
+    }
+    if (skipped) std::cout << input << ": skipped " << skipped << " malformed lines" << std::endl;
+  }
+
+  long long origin = LLONG_MAX;
+  for (auto &e : events)
+    if (e.ph == 'X') origin = std::min(origin, e.ts_ns);
+  if (origin == LLONG_MAX) origin = 0;
+  std::stable_sort(events.begin(), events.end(),
+                   [](const trace_event &x, const trace_event &y) { return x.ts_ns < y.ts_ns; });
+
+  std::ofstream out(conf.filename, std::ios_base::trunc);
+  //us with ns digits, the default 6 significant digits lose us alignment past 1 s
+  out << std::fixed << std::setprecision(3);
+  out << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[" << std::endl;
+  bool first = true;
+  std::vector<long> device_tracks;
+  for (auto &e : events)
+  {
+    if (!first) out << "," << std::endl;
+    first = false;
+    if (e.ph == 'M')
+    {
+      out << "{\"ph\":\"M\",\"pid\":" << e.pid << ",\"tid\":0,\"name\":\"process_name\",\"args\":{\"name\":\""
+          << escape(e.name) << " " << e.pid << "\"}}";
+      continue;
+    }
+    if (e.tid == -1 && std::find(device_tracks.begin(), device_tracks.end(), e.pid) == device_tracks.end())
+    {
+      device_tracks.push_back(e.pid);
+      out << "{\"ph\":\"M\",\"pid\":" << e.pid
+          << ",\"tid\":-1,\"name\":\"thread_name\",\"args\":{\"name\":\"device queue\"}}," << std::endl;
+    }
+    out << "{\"ph\":\"X\",\"pid\":" << e.pid << ",\"tid\":" << e.tid << ",\"ts\":" << (e.ts_ns - origin) / 1000.0
+        << ",\"dur\":" << e.dur_ns / 1000.0 << ",\"cat\":\"" << escape(e.cat) << "\",\"name\":\"" << escape(e.name)
+        << "\"}";
+  }
+  out << std::endl << "]}" << std::endl;
+
+  std::cout << events.size() << " events from " << conf.inputs.size() << " files written to " << conf.filename
+            << std::endl;
+  return 0;
+}
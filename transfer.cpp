@@ -0,0 +1,254 @@
+#include <sycl/sycl.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+
+using namespace sycl;
+
+/**
+ * Explicit copy bandwidth between host and device memory, the matrix for
+ * sizing streaming chunks. host memory is pageable (aligned_alloc), pinned
+ * (malloc_host) or shared (malloc_shared), device memory malloc_device.
+ * directions:
+ * h2d, d2h  host memory of each kind to and from the device
+ * d2d       device to device, once per size
+ * bidir     h2d and d2h of the same size at once on two queues, GB/s of both
+ * modes:
+ * sync      one q.memcpy of the whole size, waited
+ * async     the size in -chunk pieces submitted back to back, one wait
+ * sizes double from -min to -max, sizes the device cannot allocate are skipped.
+ * reported per point: median and best GB/s over the repetitions.
+ */
+struct config
+{
+ size_t min_bytes =4*1024;
+ size_t max_bytes =(size_t)4*1024*1024*1024;
+ size_t chunk_bytes =4*1024*1024;
+ int repetitions =10;
+ std::string device_str = "gpu";
+ std::string filename = "transfer.csv";
+};
+
+/**
+ * -min smallest transfer in KiB
+ * -max largest transfer in MiB
+ * -chunk piece size of async copies in KiB
+ * -r repetitions per point
+ * -d device sycl cpu or gpu
+ * -o output filename
+ */
+config ParseInputParams (int argc, char** argv)
+{
+  config conf;
+ int w_argc = argc - 1; // remaining arg count
+    while (w_argc > 0) {
+        char* w_arg = argv[argc - (w_argc--)]; // working arg
+        char* n_arg = (w_argc > 0) ? argv[argc - w_argc] : NULL; // next arg
+
+        if (strcmp(w_arg, "-min") == 0) {
+            w_argc--;
+            conf.min_bytes = std::max<size_t>(1, atol(n_arg)) * 1024;
+        }
+        else if (strcmp(w_arg, "-max") == 0) {
+            w_argc--;
+            conf.max_bytes = std::max<size_t>(1, atol(n_arg)) * 1024 * 1024;
+        }
+        else if (strcmp(w_arg, "-chunk") == 0) {
+            w_argc--;
+            conf.chunk_bytes = std::max<size_t>(1, atol(n_arg)) * 1024;
+        }
+        else if (strcmp(w_arg, "-r") == 0) {
+            w_argc--;
+            conf.repetitions = std::max(1, atoi(n_arg));
+        }
+        else if (strcmp(w_arg, "-d") == 0) {
+            w_argc--;
+            conf.device_str = n_arg;
+        }
+        else if (strcmp(w_arg, "-o") == 0) {
+            w_argc--;
+            conf.filename = n_arg;
+        }
+}
+
+return conf;
+}
+
+enum class host_memory { pageable, pinned, shared };
+
+const char *host_memory_name(host_memory m)
+{
+  return m == host_memory::pageable ? "pageable" : m == host_memory::pinned ? "pinned" : "shared";
+}
+
+void *host_alloc(host_memory m, size_t bytes, queue &q)
+{
+  if (m == host_memory::pinned) return malloc_host(bytes, q);
+  if (m == host_memory::shared) return malloc_shared(bytes, q);
+  return std::aligned_alloc(4096, (bytes + 4095) / 4096 * 4096);
+}
+
+void host_free(host_memory m, void *p, queue &q)
+{
+  if (m == host_memory::pageable) std::free(p);
+  else free(p, q);
+}
+
+//copy bytes, whole or in chunk pieces, and return the events
+std::vector<event> copy(queue &q, void *dst, const void *src, size_t bytes, size_t chunk)
+{
+  std::vector<event> events;
+  for (size_t off = 0; off < bytes; off += chunk)
+    events.push_back(q.memcpy((char *)dst + off, (const char *)src + off, std::min(chunk, bytes - off)));
+  return events;
+}
+
+struct point
+{
+  double gbs_median = 0;
+  double gbs_max = 0;
+  double us_median = 0;
+};
+
+//moved bytes per repetition over the wall time of one run() each
+template<typename F>
+point measure(int repetitions, double moved_bytes, F run)
+{
+  std::vector<double> us;
+  run(); //warmup RUN!
+  for (int r = 0; r < repetitions; r++)
+  {
+    auto t1 = std::chrono::steady_clock::now();
+    run();
+    auto t2 = std::chrono::steady_clock::now();
+    us.push_back(std::chrono::duration<double, std::micro>(t2 - t1).count());
+  }
+  std::sort(us.begin(), us.end());
+  point p;
+  p.us_median = us[us.size() / 2];
+  p.gbs_median = moved_bytes / (p.us_median * 1000);
+  p.gbs_max = moved_bytes / (us.front() * 1000);
+  return p;
+}
+
+void write_row(std::ofstream &myfile, const std::string &device, const std::string &direction,
+               const std::string &memory, const std::string &mode, size_t bytes, int repetitions, point p)
+{
+  std::cout << direction << " " << memory << " " << mode << " " << bytes << " B: " << p.gbs_median << " GB/s (best "
+            << p.gbs_max << ")" << std::endl;
+  myfile << "transfer" << ";" << device
+  << ";" << direction
+  << ";" << memory
+  << ";" << mode
+  << ";" << bytes
+  << ";" << repetitions
+  << ";" << p.gbs_median
+  << ";" << p.gbs_max
+  << ";" << p.us_median
+  << std::endl;
+}
+
+int main(int argc, char* argv[]) {
+
+  config conf = ParseInputParams (argc, argv);
+
+  std::ofstream myfile(conf.filename, std::ios_base::app);
+  if (myfile.tellp() == 0)
+    myfile << "benchmark;device;direction;host_memory;mode;bytes;repetitions;gbs_median;gbs_max;us_median" << std::endl;
+
+  try {
+    queue q(conf.device_str == "cpu" ? device(cpu_selector_v) : device(gpu_selector_v));
+    //second queue in the same context for the other direction of bidir
+    queue q2(q.get_context(), q.get_device());
+    std::string name = q.get_device().get_info<info::device::name>();
+    std::cout << "Running on device: " << name << "\n";
+    size_t max_alloc = q.get_device().get_info<info::device::max_mem_alloc_size>();
+    size_t global_mem = q.get_device().get_info<info::device::global_mem_size>();
+
+    const host_memory kinds[] = {host_memory::pageable, host_memory::pinned, host_memory::shared};
+    const char *modes[] = {"sync", "async"};
+
+    for (size_t bytes = conf.min_bytes; bytes <= conf.max_bytes; bytes *= 2)
+    {
+      //two device buffers for d2d and bidir
+      if (bytes > max_alloc || 2 * bytes > global_mem)
+      {
+        std::cout << bytes << " B exceeds the device allocation limits, stopping" << std::endl;
+        break;
+      }
+      char *dev_a = malloc_device<char>(bytes, q);
+      char *dev_b = malloc_device<char>(bytes, q);
+      if (dev_a == nullptr || dev_b == nullptr)
+      {
+        if (dev_a != nullptr) free(dev_a, q);
+        std::cout << "Device memory allocation failure at " << bytes << " B, stopping\n";
+        break;
+      }
+      q.memset(dev_a, 1, bytes).wait();
+
+      for (const char *mode : modes)
+      {
+        size_t chunk = strcmp(mode, "sync") == 0 ? bytes : std::min(conf.chunk_bytes, bytes);
+
+        write_row(myfile, name, "d2d", "device", mode, bytes, conf.repetitions,
+                  measure(conf.repetitions, bytes, [&]() {
+                    copy(q, dev_b, dev_a, bytes, chunk);
+                    q.wait();
+                  }));
+
+        for (host_memory kind : kinds)
+        {
+          char *h_in = (char *)host_alloc(kind, bytes, q);
+          char *h_out = (char *)host_alloc(kind, bytes, q);
+          if (h_in == nullptr || h_out == nullptr)
+          {
+            if (h_in != nullptr) host_free(kind, h_in, q);
+            std::cout << host_memory_name(kind) << " allocation failure at " << bytes << " B, skipped\n";
+            continue;
+          }
+          //touch every page so pageable memory is not first faulted inside the copy
+          std::memset(h_in, 1, bytes);
+          std::memset(h_out, 0, bytes);
+
+          write_row(myfile, name, "h2d", host_memory_name(kind), mode, bytes, conf.repetitions,
+                    measure(conf.repetitions, bytes, [&]() {
+                      copy(q, dev_a, h_in, bytes, chunk);
+                      q.wait();
+                    }));
+          write_row(myfile, name, "d2h", host_memory_name(kind), mode, bytes, conf.repetitions,
+                    measure(conf.repetitions, bytes, [&]() {
+                      copy(q, h_out, dev_a, bytes, chunk);
+                      q.wait();
+                    }));
+          write_row(myfile, name, "bidir", host_memory_name(kind), mode, bytes, conf.repetitions,
+                    measure(conf.repetitions, 2.0 * bytes, [&]() {
+                      copy(q, dev_b, h_in, bytes, chunk);
+                      copy(q2, h_out, dev_a, bytes, chunk);
+                      q.wait();
+                      q2.wait();
+                    }));
+
+          if (h_out[bytes - 1] != 1)
+          {
+            std::cout << "d2h copy failed for " << host_memory_name(kind) << std::endl;
+            exit(-1);
+          }
+          host_free(kind, h_in, q);
+          host_free(kind, h_out, q);
+        }
+      }
+      free(dev_a, q);
+      free(dev_b, q);
+    }
+  } catch (exception const &e) {
+    std::cout << "An exception is caught while copying.\n";
+    std::terminate();
+  }
+  return 0;
+}
@@ -0,0 +1,203 @@
+#include <sycl/sycl.hpp>
+#include <algorithm>
+#include <iostream>
+#include <string>
+#include <fstream>
+#include <chrono>
+
+#include "runtime.hpp"
+#include "autotune.hpp"
+
+
+using namespace sycl;
+
+/**
+ * VectorAdd with range<1> (runtime picks everything) against the nd_range
+ * vec variant with tuned launch parameters. parameters come from the tune
+ * cache file when this device and size class were tuned before, otherwise
+ * the autotuner searches them and writes them to the cache.
+ */
+struct config
+{
+ size_t vector_size =1024*256*64; //number of elements (4 byte int)
+ int repetitions =10;
+ bool retune=false;
+ bool do_validation=true;
+ std::string device_str = "gpu";
+ std::string cache_file = "tune_cache.csv";
+ std::string filename = "tuned_add.csv";
+ launch_params manual;
+ bool use_manual=false;
+};
+
+/**
+ * -k size in KiB
+ * -m size in MiB
+ * -d device sycl cpu or gpu
+ * -r repetitions
+ * -cache tune cache filename
+ * --retune ignore the cache entry and search again
+ * -wg -ipw -vec fixed work-group size, items per work-item, vec width (no tuning)
+ * --nv no validation
+ * -o output filename
+ */
+config ParseInputParams (int argc, char** argv)
+{
+  config conf;
+ int w_argc = argc - 1; // remaining arg count
+    while (w_argc > 0) {
+        char* w_arg = argv[argc - (w_argc--)]; // working arg
+        char* n_arg = (w_argc > 0) ? argv[argc - w_argc] : NULL; // next arg
+
+        if (strcmp(w_arg, "--nv") == 0) {
+            conf.do_validation = false;
+        }
+        else if (strcmp(w_arg, "--retune") == 0) {
+            conf.retune = true;
+        }
+        else if (strcmp(w_arg, "-k") == 0) {
+            w_argc--;
+            conf.vector_size = 256 * std::max<size_t>(1, atol(n_arg));
+        }
+        else if (strcmp(w_arg, "-m") == 0) {
+            w_argc--;
+            conf.vector_size = 256 * 1024 * std::max<size_t>(1, atol(n_arg));
+        }
+        else if (strcmp(w_arg, "-d") == 0) {
+            w_argc--;
+            conf.device_str = n_arg;
+        }
+        else if (strcmp(w_arg, "-r") == 0) {
+            w_argc--;
+            conf.repetitions = std::max(1, atoi(n_arg));
+        }
+        else if (strcmp(w_arg, "-cache") == 0) {
+            w_argc--;
+            conf.cache_file = n_arg;
+        }
+        else if (strcmp(w_arg, "-wg") == 0) {
+            w_argc--;
+            conf.manual.wg_size = std::max<size_t>(1, atol(n_arg));
+            conf.use_manual = true;
+        }
+        else if (strcmp(w_arg, "-ipw") == 0) {
+            w_argc--;
+            conf.manual.items_per_wi = std::max(1, atoi(n_arg));
+            conf.use_manual = true;
+        }
+        else if (strcmp(w_arg, "-vec") == 0) {
+            w_argc--;
+            conf.manual.vec_width = std::max(1, atoi(n_arg));
+            conf.use_manual = true;
+        }
+        else if (strcmp(w_arg, "-o") == 0) {
+            w_argc--;
+            conf.filename = n_arg;
+        }
+}
+
+return conf;
+}
+
+bool validate(const int *sum, size_t size)
+{
+  for (size_t i = 0; i < size; i++)
+  {
+    if (sum[i] != (int)(2 * i))
+    {
+      std::cout << "Vector add failed on device. at index " << i << "\n";
+      return false;
+    }
+  }
+  return true;
+}
+
+int main(int argc, char* argv[]) {
+
+  config conf = ParseInputParams (argc, argv);
+  size_t n = conf.vector_size;
+
+  std::ofstream myfile(conf.filename, std::ios_base::app);
+  if (myfile.tellp() == 0)
+    myfile << "benchmark;datasize;device;variant;wg_size;items_per_wi;vec_width;time_ms_event;gbs" << std::endl;
+
+  try {
+    auto &dev = coprocessing_runtime::instance().get(conf.device_str);
+    std::string device_name = dev.q.get_device().get_info<info::device::name>();
+    std::cout << "Running on device: " << device_name << "\n";
+
+    int *a = dev.pool().acquire<int>(n);
+    int *b = dev.pool().acquire<int>(n);
+    int *sum = dev.pool().acquire<int>(n);
+    if (!a || !b || !sum) { std::cout << "Shared memory allocation failure.\n"; exit(-1); }
+    for (size_t i = 0; i < n; i++) a[i] = b[i] = i;
+
+    //pick launch parameters: command line, cache, or a new search
+    launch_params p = conf.manual;
+    tune_cache cache(conf.cache_file);
+    int cls = size_class(n);
+    if (!conf.use_manual)
+    {
+      if (!conf.retune && cache.lookup(device_name, cls, p))
+        std::cout << "tuned settings from " << conf.cache_file << std::endl;
+      else
+      {
+        auto t1 = std::chrono::steady_clock::now();
+        auto best = autotune(dev.q, a, b, sum, n);
+        auto t2 = std::chrono::steady_clock::now();
+        p = best.first;
+        //no candidate ran, the defaults are not a tuning result to reuse
+        if (best.second < 0)
+          std::cout << "no launch configuration ran, using the defaults uncached" << std::endl;
+        else
+          cache.store(device_name, cls, p, best.second);
+        std::cout << "autotuning took " << std::chrono::duration_cast<std::chrono::milliseconds>(t2 - t1).count()
+                  << " ms" << std::endl;
+      }
+    }
+    std::cout << "wg_size " << p.wg_size << " items_per_wi " << p.items_per_wi << " vec_width " << p.vec_width << std::endl;
+
+    //warmup RUN!
+    VectorAdd(dev, a, b, sum, n);
+    VectorAddND(dev.q, a, b, sum, n, p).wait();
+
+    for (int r = 0; r < conf.repetitions; r++)
+    {
+      double range_ns = VectorAdd(dev, a, b, sum, n);
+      event e = VectorAddND(dev.q, a, b, sum, n, p);
+      e.wait();
+      double nd_ns = e.template get_profiling_info<info::event_profiling::command_end>() -
+                     e.template get_profiling_info<info::event_profiling::command_start>();
+
+      for (auto row : {std::make_pair(std::string("range"), range_ns), std::make_pair(std::string("nd_range"), nd_ns)})
+      {
+        double gbs = 3.0 * n * sizeof(int) / row.second;
+        bool nd = row.first == "nd_range";
+        std::cout << row.first << " " << row.second / 1000000 << " ms " << gbs << " GB/s" << std::endl;
+        myfile << "tuned_add" << ";" << n
+        << ";" << conf.device_str
+        << ";" << row.first
+        << ";" << (nd ? p.wg_size : 0)
+        << ";" << (nd ? p.items_per_wi : 0)
+        << ";" << (nd ? p.vec_width : 0)
+        << ";" << row.second / 1000000
+        << ";" << gbs
+        << std::endl;
+      }
+    }
+
+    if (conf.do_validation && !validate(sum, n))
+    {
+      // return -1 if validation failed
+      exit(-1);
+    }
+
+    dev.pool().release(a);
+    dev.pool().release(b);
+    dev.pool().release(sum);
+  } catch (exception const &e) {
+    std::cout << "An exception is caught while adding two vectors.\n";
+    std::terminate();
+  }
+  return 0;
+}
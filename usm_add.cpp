@@ -5,7 +5,25 @@
 #include <fstream>
 #include <omp.h>
 #include <thread>
+#include <algorithm>
+#include <sstream>
+#include <vector>
+
+#include "runtime.hpp"
+#include "calibration.hpp"
+#include "validation.hpp"
+#include "hugepages.hpp"
+#include "stream.hpp"
+
+// mem_advise advice values are backend specific. defaults are the Level Zero
+// ze_memory_advice_t values, override with -D for other backends
+#ifndef USM_ADVISE_PREFER_DEVICE
+#define USM_ADVISE_PREFER_DEVICE 2 // ZE_MEMORY_ADVICE_SET_PREFERRED_LOCATION
+#endif
 
+#ifndef USM_ADVISE_PREFER_HOST
+#define USM_ADVISE_PREFER_HOST 8 // ZE_MEMORY_ADVICE_SET_SYSTEM_MEMORY_PREFERRED_LOCATION
+#endif
 
 
 using namespace sycl;
@@ -22,12 +40,27 @@ struct config
  size_t mib=1024;
  bool usm=true;
  bool do_validation=true;
+ validation_mode validation=validation_mode::full;
  hardware hw=gpu;  //cpu alternative
  std::string device_str = "gpu";
  std::string filename = "add_gpu.csv";
  float share_cpu =0.5f;
  size_t start_index=0;
  std::string processing_mode ="Co-processing";
+ bool stage=false; //prefetch/mem_advise partitions before the kernel
+ bool auto_split=false; //start_index from the calibration profile
+ std::string profile_file = "coprocessing_profile.csv";
+ size_t host_crossover=0; //sizes below run as single thread host loop
+ page_policy pages=page_policy::system; //page size of the input and shared arrays
+ std::string peak_file = "stream_peak.csv"; //measured peaks written by stream
+ std::string roofline_file = "roofline.csv"; //achieved against attainable bandwidth
+ //sweep mode, one process for all points. empty list keeps the single value
+ std::string sweep_m;   //sizes in MiB
+ std::string sweep_omp; //openmp threads
+ std::string sweep_s;   //cpu shares
+ std::string sweep_d;   //devices
+ int repetitions=1;     //runs per sweep point
+ bool sweep=false;
 };
 
 struct times
@@ -62,10 +95,20 @@ static auto exception_handler = [](sycl::exception_list e_list) {
  * -k size in KiB
  * -m size in MiB
  * -d device sycl cpu or gpu
- * --nv no validation
+ * --nv no validation, same as -val none
+ * -val validation mode none, serial, full, sampled or checksum
  * -o output filename
- * -s share cpu factor 0..1
+ * -s share cpu factor 0..1, or auto to predict it from the calibration profile
+ * -profile calibration profile filename written by calibrate
  * -omp openmp threads int
+ * -stage prefetch device partition and advise cpu partition to host
+ * -pages system, 4k, thp or hugetlb page policy for input and shared arrays
+ * -peak peak bandwidth filename written by stream, for the roofline report
+ * -roofline roofline report filename
+ * -sweep-m sizes in MiB, -sweep-omp thread counts, -sweep-s cpu shares,
+ * -sweep-d devices: comma separated values, lo:hi doubling or lo:hi:step.
+ *   runs every combination in this process, see run_sweep
+ * -r runs per sweep point
  */
 config ParseInputParams (int argc, char** argv)
 {
@@ -76,9 +119,14 @@ config ParseInputParams (int argc, char** argv)
         char* n_arg = (w_argc > 0) ? argv[argc - w_argc] : NULL; // next arg
 
         if (strcmp(w_arg, "--nv") == 0) {
-            w_argc--;
             conf.do_validation = false;
-        
+            conf.validation = validation_mode::none;
+        }
+
+        else if (strcmp(w_arg, "-val") == 0) {
+            w_argc--;
+            conf.validation = parse_validation_mode(n_arg);
+            conf.do_validation = conf.validation != validation_mode::none;
         }
 
         else if (strcmp(w_arg, "-k") == 0) {
@@ -131,6 +179,10 @@ config ParseInputParams (int argc, char** argv)
             
         }
 
+        else if (strcmp(w_arg, "-stage") == 0) {
+            conf.stage = true;
+        }
+
         else if (strcmp(w_arg, "-o") == 0) {
             w_argc--;
             std::string ofile = n_arg;
@@ -141,11 +193,65 @@ config ParseInputParams (int argc, char** argv)
         
         else if (strcmp(w_arg, "-s") == 0) {
             w_argc--;
+            if (strcmp(n_arg, "auto") == 0) {
+                conf.auto_split = true;
+            }
+            else {
             float share_cpu  = atof(n_arg);
             
             
             
             conf.share_cpu = share_cpu;
+            }
+        }
+
+        else if (strcmp(w_arg, "-pages") == 0) {
+            w_argc--;
+            conf.pages = parse_page_policy(n_arg);
+        }
+
+        else if (strcmp(w_arg, "-sweep-m") == 0) {
+            w_argc--;
+            conf.sweep_m = n_arg;
+            conf.sweep = true;
+        }
+
+        else if (strcmp(w_arg, "-sweep-omp") == 0) {
+            w_argc--;
+            conf.sweep_omp = n_arg;
+            conf.sweep = true;
+        }
+
+        else if (strcmp(w_arg, "-sweep-s") == 0) {
+            w_argc--;
+            conf.sweep_s = n_arg;
+            conf.sweep = true;
+        }
+
+        else if (strcmp(w_arg, "-sweep-d") == 0) {
+            w_argc--;
+            conf.sweep_d = n_arg;
+            conf.sweep = true;
+        }
+
+        else if (strcmp(w_arg, "-r") == 0) {
+            w_argc--;
+            conf.repetitions = std::max(1, atoi(n_arg));
+        }
+
+        else if (strcmp(w_arg, "-peak") == 0) {
+            w_argc--;
+            conf.peak_file = n_arg;
+        }
+
+        else if (strcmp(w_arg, "-roofline") == 0) {
+            w_argc--;
+            conf.roofline_file = n_arg;
+        }
+
+        else if (strcmp(w_arg, "-profile") == 0) {
+            w_argc--;
+            conf.profile_file = n_arg;
         }
 
 }
@@ -167,12 +273,54 @@ double VectorAdd(queue &q, const int *a, const int *b, int *sum, size_t size) {
 }
 
 
+/**
+ * Stage shared allocations for co-processing: the device partition
+ * [start_index, vector_size) is advised to and prefetched onto the device,
+ * the cpu partition [0, start_index) is advised to stay in host memory so
+ * neither side migrates pages through faults during the timed run.
+ * returns the prefetch events, the device kernel has to depend on them
+ */
+std::vector<event> StageShared(queue &q, config conf, int *a, int *b, int *sum)
+{
+  std::vector<event> staged;
+  size_t dev_count = conf.vector_size - std::min(conf.start_index, conf.vector_size);
+
+  for (int *p : {a, b, sum})
+  {
+    if (dev_count > 0)
+    {
+      q.mem_advise(p + conf.start_index, dev_count * sizeof(int), USM_ADVISE_PREFER_DEVICE);
+      staged.push_back(q.prefetch(p + conf.start_index, dev_count * sizeof(int)));
+    }
+    if (conf.start_index > 0)
+      q.mem_advise(p, std::min(conf.start_index, conf.vector_size) * sizeof(int), USM_ADVISE_PREFER_HOST);
+  }
+  return staged;
+}
+
 void InitializeArray(int *a, size_t size, bool usm) {
   for (size_t i = 0; i < size; i++) a[i] = i;
 }
 
+//rows of a sweep, written to the files once at the end by run_sweep
+std::stringstream sweep_rows;
+std::stringstream sweep_roofline_rows;
+
  void print_to_file (config conf, times timer  )
   {
+    std::stringstream row;
+    row <<"usm_add"<<";"<< conf.vector_size
+    <<";"<<conf.device_str
+    <<";"<<timer.runtime_event_ms /1000000<<";"<<timer.runtime_chrono_ms/1000 
+    <<";"<< conf.omp_threads
+    <<";"<< conf.share_cpu
+    <<";"<< conf.processing_mode
+    <<std::endl;
+    if(conf.sweep)
+    {
+      sweep_rows << row.str();
+      return;
+    }
 
  std::fstream myfile(conf.filename,std::ios_base::app | std::ios_base::trunc);
     myfile.open(conf.filename);
@@ -194,13 +342,7 @@ void InitializeArray(int *a, size_t size, bool usm) {
     myfile.open(conf.filename);
     myfile.seekg (0, std::ios::end);
 
-    myfile <<"usm_add"<<";"<< conf.vector_size
-    <<";"<<conf.device_str
-    <<";"<<timer.runtime_event_ms /1000000<<";"<<timer.runtime_chrono_ms/1000 
-    <<";"<< conf.omp_threads
-    <<";"<< conf.share_cpu
-    <<";"<< conf.processing_mode
-    <<std::endl;
+    myfile << row.str();
 
 
   }
@@ -246,6 +388,13 @@ void InitializeArray(int *a, size_t size, bool usm) {
 
   }
 
+  //single thread SIMD add for vectors below the calibrated crossover
+  void simd_add (int * a, int * b, int * sum_parallel, size_t size)
+  {
+    #pragma omp simd
+    for(size_t i=0; i<size; i++) sum_parallel[i] = a[i]+b[i];
+  }
+
   //run openmp add on cpu
   void omp_add (int * a, int * b, int * sum_parallel, config conf)
   {
@@ -274,44 +423,93 @@ void benchmark(config conf, int * a_in, int * b_in, int * c_in, size_t vectorsiz
 
   printcfg(conf);
   
-  //select CPU default, GPU else
-  auto selector = sycl::cpu_selector_v;
-  if(conf.hw == gpu)
-   selector = sycl::gpu_selector_v;
-
-
    //allocate unified memory buffer
   try {
-    queue q(selector,property::queue::enable_profiling{});
+    //queue, kernels and USM blocks are kept by the runtime across calls,
+    //only the first benchmark() per device pays for queue creation and JIT
+    auto &dev = coprocessing_runtime::instance().get(conf.device_str);
+    queue &q = dev.q;
+    usm_pool &pool = dev.pool();
 
     // Print out the device information used for the kernel code.
     std::cout << "Running on device: "
              << q.get_device().get_info<info::device::name>() << "\n";
+
+    //pick the split from the calibrated models instead of share_cpu
+    if(conf.auto_split)
+    {
+      device_profile profile;
+      if(profile_store(conf.profile_file).find(q.get_device().get_info<info::device::name>(), profile))
+      {
+        conf.start_index = profile.predict_start_index(conf.vector_size, conf.omp_threads);
+        conf.share_cpu = (float)conf.start_index / conf.vector_size;
+        conf.host_crossover = profile.host_crossover;
+        std::cout << "Predicted GPU start index: " << conf.start_index << " (CPU share " << conf.share_cpu << ")" << std::endl;
+      }
+      else
+      {
+        std::cout << "No calibration profile for this device in " << conf.profile_file
+                  << ", using CPU share " << conf.share_cpu << std::endl;
+      }
+    }
   
     //allocate unified memory
-    int *a = malloc_shared<int>(conf.vector_size, q);
-    int *b = malloc_shared<int>(conf.vector_size, q);
+    int *a = pool.acquire<int>(conf.vector_size);
+    int *b = pool.acquire<int>(conf.vector_size);
 
-    int *sum_sequential = malloc_shared<int>(conf.vector_size, q);
-    int *sum_parallel = malloc_shared<int>(conf.vector_size, q);
+    //only the serial check needs a fourth full size array
+    int *sum_sequential = conf.validation == validation_mode::serial ? pool.acquire<int>(conf.vector_size) : nullptr;
+    int *sum_parallel = pool.acquire<int>(conf.vector_size);
 
   //exit if allocation failed
-    if ((a == nullptr) || (b == nullptr) || (sum_sequential == nullptr) ||
+    if ((a == nullptr) || (b == nullptr) || (conf.validation == validation_mode::serial && sum_sequential == nullptr) ||
         (sum_parallel == nullptr)) {
-      if (a != nullptr) free(a, q);
-      if (b != nullptr) free(b, q);
-      if (sum_sequential != nullptr) free(sum_sequential, q);
-      if (sum_parallel != nullptr) free(sum_parallel, q);
+      pool.release(a);
+      pool.release(b);
+      pool.release(sum_sequential);
+      pool.release(sum_parallel);
 
       std::cout << "Shared memory allocation failure.\n";
       exit(-1);
     }
 
+    //shared arrays are mapped by the backend, hugetlb is advised as thp there
+    for (int *p : {a, b, sum_parallel}) advise_pages(p, conf.vector_size * sizeof(int), conf.pages);
+
     // Initialize input arrays with values from 0 to array_size - 1
     InitializeArray(a, conf.vector_size, true);
     InitializeArray(b, conf.vector_size, true);
     int i;
 
+    times timer;
+    if(conf.stage)
+    {
+      //copy the device partition first and let its prefetch run while the
+      //host copies the cpu partition
+      auto stage1 = std::chrono::steady_clock::now();
+      size_t split = std::min(conf.start_index, conf.vector_size);
+      for(size_t i = split; i < conf.vector_size; i++)
+      {
+        a[i] = a_in[i];
+        b[i] = b_in[i];
+      }
+      std::vector<event> staged = StageShared(q, conf, a, b, sum_parallel);
+      for(size_t i = 0; i < split; i++)
+      {
+        a[i] = a_in[i];
+        b[i] = b_in[i];
+      }
+      //warmup only on the device partition, a full warmup would pull the
+      //cpu partition over to the device again
+      if(split < conf.vector_size)
+        VectorAdd(dev, a + split, b + split, sum_parallel + split, conf.vector_size - split, staged);
+      event::wait(staged);
+      auto stage2 = std::chrono::steady_clock::now();
+      std::cout << "Staging time us: "
+                << std::chrono::duration_cast<std::chrono::microseconds>(stage2 - stage1).count() << std::endl;
+    }
+    else
+    {
     //Copy over input arrays to unified mem
     for(int i =0; i < conf.vector_size;i++)
     {
@@ -319,22 +517,39 @@ void benchmark(config conf, int * a_in, int * b_in, int * c_in, size_t vectorsiz
        b[i] =b_in[i];
     }
 
-    times timer;
 //warmup RUN!
-  timer.runtime_event_ms =VectorAdd(q, a, b, sum_parallel, conf.vector_size);
+  //the host fast path warms up on the host, a device warmup would migrate
+  //the shared arrays away and time their way back
+  if(conf.vector_size < conf.host_crossover)
+    simd_add(a, b, sum_parallel, conf.vector_size);
+  else
+    timer.runtime_event_ms =VectorAdd(dev, a, b, sum_parallel, conf.vector_size);
+    }
    int n_per_thread = conf.vector_size / conf.omp_threads;
   
   auto total1 = std::chrono::steady_clock::now();
   auto total2 = std::chrono::steady_clock::now();
      
+      //tiny vectors: no thread, OpenMP team or kernel launch at all
+      if(conf.vector_size < conf.host_crossover)
+      {
+        conf.processing_mode = "host fast path";
+        total1 = std::chrono::steady_clock::now();
+        simd_add(a, b, sum_parallel, conf.vector_size);
+        total2 = std::chrono::steady_clock::now();
+        //fractional us, tiny sizes take well under one
+        timer.runtime_chrono_ms =std::chrono::duration<double, std::micro>(total2 - total1).count();
+        //no kernel ran, do not report the warmup's event time
+        timer.runtime_event_ms = 0;
+      }
       //Co Processing
-      if(conf.start_index>= 1 && conf.start_index <  conf.vector_size-1)
+      else if(conf.start_index>= 1 && conf.start_index <  conf.vector_size-1)
       {
        
         conf.processing_mode = "coprocessing";
         total1 = std::chrono::steady_clock::now();
 std::thread tt(omp_add, a,b,sum_parallel,conf);
- timer.runtime_event_ms =VectorAdd(q, a+conf.start_index, b+conf.start_index, sum_parallel+conf.start_index, conf.vector_size-conf.start_index);
+ timer.runtime_event_ms =VectorAdd(dev, a+conf.start_index, b+conf.start_index, sum_parallel+conf.start_index, conf.vector_size-conf.start_index);
    tt.join();     
    total2 = std::chrono::steady_clock::now();
  timer.runtime_chrono_ms =std::chrono::duration_cast<std::chrono::microseconds>(total2 - total1).count();
@@ -345,7 +560,7 @@ std::thread tt(omp_add, a,b,sum_parallel,conf);
       {
         conf.processing_mode = "Sycl only";
         total1 = std::chrono::steady_clock::now();
-         timer.runtime_event_ms =VectorAdd(q, a, b, sum_parallel, conf.vector_size);
+         timer.runtime_event_ms =VectorAdd(dev, a, b, sum_parallel, conf.vector_size);
          total2 = std::chrono::steady_clock::now();
          timer.runtime_chrono_ms =std::chrono::duration_cast<std::chrono::microseconds>(total2 - total1).count();
 
@@ -360,10 +575,16 @@ std::thread tt(omp_add, a,b,sum_parallel,conf);
    total2 = std::chrono::steady_clock::now();
  timer.runtime_chrono_ms =std::chrono::duration_cast<std::chrono::microseconds>(total2 - total1).count();
  }
+      if(conf.stage) conf.processing_mode += " staged";
       
 
 
-   if(!validate(a,b,sum_sequential,sum_parallel, conf.vector_size))
+   bool valid = true;
+   if(conf.validation == validation_mode::serial)
+     valid = validate(a,b,sum_sequential,sum_parallel, conf.vector_size);
+   else
+     valid = validate_add(conf.validation, q, a, b, sum_parallel, conf.vector_size, conf.start_index, conf.omp_threads);
+   if(!valid)
    {
    // return -1 if validation failed
    exit(-1);
@@ -371,23 +592,149 @@ std::thread tt(omp_add, a,b,sum_parallel,conf);
  
 
   //copy over to daphne output
-  for(int i =0;i<vector_size;i++)
+  for(size_t i =0;i<conf.vector_size;i++)
   {
     c_in[i] = sum_parallel[i];
   }
 
   print_to_file(conf,timer);
 
+    //achieved bandwidth against the stream peaks of both sides for this split
+    //read once per process, a sweep does not reparse it for every point
+    static const peak_store peaks(conf.peak_file);
+    double bytes = stream_bytes("add", conf.vector_size, sizeof(int));
+    double share = (double)std::min(conf.start_index, conf.vector_size) / conf.vector_size;
+    double peak = coprocess_peak_gbs(bytes, share,
+                                     peaks.find("host", "omp" + std::to_string(conf.omp_threads), "add"),
+                                     peaks.find(q.get_device().get_info<info::device::name>(), "sycl", "add"));
+    //timer.runtime_chrono_ms may hold whole us, a tiny run can measure 0
+    double seconds = std::chrono::duration<double>(total2 - total1).count();
+    if (seconds > 0)
+    {
+      double gbs = bytes / (seconds * 1e9);
+      //a sweep buffers its rows and writes them once at the end
+      if (conf.sweep)
+        report_roofline(sweep_roofline_rows, "usm_add", conf.vector_size, conf.device_str, conf.processing_mode,
+                        gbs, peak);
+      else
+        report_roofline(conf.roofline_file, "usm_add", conf.vector_size, conf.device_str, conf.processing_mode,
+                        gbs, peak);
+    }
+
 
-    free(a, q);
-    free(b, q);
-    free(sum_sequential, q);
-    free(sum_parallel, q);
+    pool.release(a);
+    pool.release(b);
+    pool.release(sum_sequential);
+    pool.release(sum_parallel);
   } catch (exception const &e) {
     std::cout << "An exception is caught while adding two vectors.\n";
     std::terminate();
   }
 }
+
+/**
+ * sweep values: comma separated items, each a single value, lo:hi doubling
+ * from lo or lo:hi:step. fallback if the list is empty
+ */
+std::vector<double> parse_sweep(const std::string &list, double fallback)
+{
+  std::vector<double> values;
+  std::stringstream ss(list);
+  std::string item;
+  while (std::getline(ss, item, ','))
+  {
+    double lo = 0, hi = 0, step = 0;
+    int fields = sscanf(item.c_str(), "%lf:%lf:%lf", &lo, &hi, &step);
+    if (fields == 1) values.push_back(lo);
+    else if (fields == 2 && lo > 0)
+      for (double v = lo; v <= hi * (1 + 1e-9); v *= 2) values.push_back(v);
+    else if (fields == 3 && step > 0)
+      for (double v = lo; v <= hi + step * 1e-6; v += step) values.push_back(v);
+    else
+    {
+      //e.g. 0:1, doubling never leaves 0
+      std::cout << "sweep item " << item << " is not a value, lo:hi with lo > 0 or lo:hi:step with step > 0"
+                << std::endl;
+      exit(-1);
+    }
+  }
+  if (values.empty()) values.push_back(fallback);
+  return values;
+}
+
+/**
+ * every combination of device, size, omp threads and cpu share in one
+ * process, replacing one process launch per point. queue, kernels and USM
+ * blocks come from coprocessing_runtime, and the pool is primed with blocks
+ * of the largest size so later points within usm_pool::max_fallback_ratio
+ * of it reuse them. inputs are generated once at the largest size, rows
+ * are written to the file in one go at the end
+ */
+void run_sweep(config conf)
+{
+  std::vector<double> sizes = parse_sweep(conf.sweep_m, conf.vector_size / (256.0 * 1024));
+  std::vector<double> threads = parse_sweep(conf.sweep_omp, conf.omp_threads);
+  std::vector<double> shares = parse_sweep(conf.sweep_s, conf.share_cpu);
+  std::vector<std::string> devices;
+  std::stringstream ss(conf.sweep_d);
+  std::string item;
+  while (std::getline(ss, item, ',')) devices.push_back(item);
+  if (devices.empty()) devices.push_back(conf.device_str);
+
+  size_t max_size = 1;
+  for (double m : sizes) max_size = std::max(max_size, (size_t)(m * 256 * 1024));
+
+  int * in_a=(int *)host_pages_alloc(sizeof(int)*max_size, conf.pages);
+  int * in_b=(int *)host_pages_alloc(sizeof(int)*max_size, conf.pages);
+  int * out_c=(int *)host_pages_alloc(sizeof(int)*max_size, conf.pages);
+  if (!in_a || !in_b || !out_c) { std::cout << "Host memory allocation failure.\n"; exit(-1); }
+  InitializeArray(in_a,max_size,false);
+  InitializeArray(in_b,max_size,false);
+
+  size_t points = 0;
+  auto t1 = std::chrono::steady_clock::now();
+  for (auto &d : devices)
+  {
+    conf.device_str = d;
+    conf.hw = d == "cpu" ? cpu : gpu;
+
+    //benchmark() holds at most four arrays at once
+    usm_pool &pool = coprocessing_runtime::instance().get(d).pool();
+    std::vector<int *> blocks;
+    for (int k = 0; k < 4; k++) blocks.push_back(pool.acquire<int>(max_size));
+    for (int *p : blocks) pool.release(p);
+
+    for (double m : sizes)
+      for (double t : threads)
+        for (double sh : shares)
+          for (int r = 0; r < conf.repetitions; r++)
+          {
+            config point = conf;
+            point.omp_threads = std::max(1, (int)t);
+            point.share_cpu = (float)sh;
+            benchmark(point, in_a, in_b, out_c, std::max<size_t>(1, (size_t)(m * 256 * 1024)));
+            points++;
+          }
+  }
+  auto t2 = std::chrono::steady_clock::now();
+
+  std::ofstream myfile(conf.filename, std::ios_base::app);
+  if (myfile.tellp() == 0)
+    myfile << "benchmark;datasize;device;time_ms_event;time_ms_chrono;omp_threads;cpu_share;mode" << std::endl;
+  myfile << sweep_rows.str();
+  if (sweep_roofline_rows.tellp() > 0)
+  {
+    std::ofstream roofline(conf.roofline_file, std::ios_base::app);
+    if (roofline.tellp() == 0) roofline << roofline_header << std::endl;
+    roofline << sweep_roofline_rows.str();
+  }
+  std::cout << "Sweep: " << points << " points in "
+            << std::chrono::duration<double>(t2 - t1).count() << " s" << std::endl;
+
+  host_pages_free(in_a, sizeof(int)*max_size);
+  host_pages_free(in_b, sizeof(int)*max_size);
+  host_pages_free(out_c, sizeof(int)*max_size);
+}
    
 int main(int argc, char* argv[]) {
 
@@ -407,13 +754,19 @@ int main(int argc, char* argv[]) {
         }
     }
 
+
+  if(conf.sweep)
+  {
+    run_sweep(conf);
+    return 0;
+  }
   
   //set params, generate random in main. throw in data with pointers
   //default behavior half gpu half cpu
   size_t vector_size =1024*1024*256; //1 Gib per array int
-  int * in_a=(int *)malloc(sizeof(int)*vector_size);
-  int * in_b=(int *)malloc(sizeof(int)*vector_size);
-  int * out_c=(int *)malloc(sizeof(int)*vector_size);
+  int * in_a=(int *)host_pages_alloc(sizeof(int)*vector_size, conf.pages);
+  int * in_b=(int *)host_pages_alloc(sizeof(int)*vector_size, conf.pages);
+  int * out_c=(int *)host_pages_alloc(sizeof(int)*vector_size, conf.pages);
   
 
   //genreate data, replace by dapohne input
@@ -0,0 +1,213 @@
+#include <sycl/sycl.hpp>
+#include <algorithm>
+#include <iostream>
+#include <string>
+#include <fstream>
+#include <chrono>
+#include <vector>
+
+#include "runtime.hpp"
+
+
+using namespace sycl;
+
+/**
+ * Side-by-side VectorAdd on the different USM kinds. each repetition writes
+ * the inputs on the host, then the timed region makes them visible to the
+ * device, runs the kernel and reads the result back on the host:
+ * shared:        malloc_shared, migration through page faults in the kernel
+ * shared_staged: malloc_shared, explicit prefetch before the kernel
+ * host:          malloc_host, kernel reads host memory directly
+ * device:        malloc_device, explicit memcpy in and out
+ */
+struct config
+{
+ size_t vector_size =1024*256; //number of elements (4 byte int)
+ size_t mib=0;
+ int repetitions =10;
+ std::string device_str = "gpu";
+ std::string filename = "usm_kinds.csv";
+};
+
+struct times
+{
+ double runtime_chrono_ms=0.f;
+ double runtime_event_ms=0.f;
+};
+
+/**
+ * -k size in KiB
+ * -m size in MiB
+ * -r repetitions
+ * -d device sycl cpu or gpu
+ * -o output filename
+ */
+config ParseInputParams (int argc, char** argv)
+{
+  config conf;
+ int w_argc = argc - 1; // remaining arg count
+    while (w_argc > 0) {
+        char* w_arg = argv[argc - (w_argc--)]; // working arg
+        char* n_arg = (w_argc > 0) ? argv[argc - w_argc] : NULL; // next arg
+
+        if (strcmp(w_arg, "-k") == 0) {
+            w_argc--;
+            conf.vector_size = 256 * std::max<size_t>(1, atol(n_arg));
+        }
+        else if (strcmp(w_arg, "-m") == 0) {
+            w_argc--;
+            conf.mib = std::max<size_t>(1, atol(n_arg));
+            conf.vector_size = 256 * 1024 * conf.mib;
+        }
+        else if (strcmp(w_arg, "-r") == 0) {
+            w_argc--;
+            conf.repetitions = std::max(1, atoi(n_arg));
+        }
+        else if (strcmp(w_arg, "-d") == 0) {
+            w_argc--;
+            conf.device_str = n_arg;
+        }
+        else if (strcmp(w_arg, "-o") == 0) {
+            w_argc--;
+            conf.filename = n_arg;
+        }
+}
+
+return conf;
+}
+
+double event_ns(event e)
+{
+  return(e.template get_profiling_info<info::event_profiling::command_end>() -
+       e.template get_profiling_info<info::event_profiling::command_start>());
+}
+
+event AddKernel(queue &q, const int *a, const int *b, int *sum, size_t size,
+                const std::vector<event> &deps = {})
+{
+  return q.submit([&](handler &h) {
+    h.depends_on(deps);
+    h.parallel_for(range<1>{size}, [=](auto i) { sum[i] = a[i] + b[i]; });
+  });
+}
+
+//read every result on the host so pages that live on the device come back
+long checksum(const int *sum, size_t size)
+{
+  long s = 0;
+  for (size_t i = 0; i < size; i++) s += sum[i];
+  return s;
+}
+
+times run_kind(coprocessing_runtime::device_entry &dev, const std::string &kind,
+               const std::vector<int> &a_in, const std::vector<int> &b_in, size_t size)
+{
+  queue &q = dev.q;
+  size_t bytes = size * sizeof(int);
+  usm::alloc alloc = usm::alloc::shared;
+  if (kind == "host") alloc = usm::alloc::host;
+  if (kind == "device") alloc = usm::alloc::device;
+
+  usm_pool &pool = dev.pool(alloc);
+  int *a = pool.acquire<int>(size);
+  int *b = pool.acquire<int>(size);
+  int *sum = pool.acquire<int>(size);
+  //host side staging/result buffer for the device kind
+  int *host_sum = dev.pool(usm::alloc::host).acquire<int>(size);
+  if (a == nullptr || b == nullptr || sum == nullptr || host_sum == nullptr)
+  {
+    std::cout << "USM allocation failure.\n";
+    exit(-1);
+  }
+
+  //host writes the inputs, outside of the timed region
+  if (alloc != usm::alloc::device)
+  {
+    std::copy(a_in.begin(), a_in.end(), a);
+    std::copy(b_in.begin(), b_in.end(), b);
+  }
+
+  times timer;
+  long s = 0;
+  auto t1 = std::chrono::steady_clock::now();
+  if (kind == "device")
+  {
+    event ca = q.memcpy(a, a_in.data(), bytes);
+    event cb = q.memcpy(b, b_in.data(), bytes);
+    event k = AddKernel(q, a, b, sum, size, {ca, cb});
+    q.memcpy(host_sum, sum, bytes, k).wait();
+    timer.runtime_event_ms = event_ns(k);
+    s = checksum(host_sum, size);
+  }
+  else if (kind == "shared_staged")
+  {
+    std::vector<event> staged;
+    for (int *p : {a, b, sum}) staged.push_back(q.prefetch(p, bytes));
+    event k = AddKernel(q, a, b, sum, size, staged);
+    k.wait();
+    timer.runtime_event_ms = event_ns(k);
+    s = checksum(sum, size);
+  }
+  else
+  {
+    event k = AddKernel(q, a, b, sum, size);
+    k.wait();
+    timer.runtime_event_ms = event_ns(k);
+    s = checksum(sum, size);
+  }
+  auto t2 = std::chrono::steady_clock::now();
+  timer.runtime_chrono_ms = std::chrono::duration_cast<std::chrono::microseconds>(t2 - t1).count();
+
+  //inputs are i and i, so the sum is known
+  long expected = (long)size * (long)(size - 1);
+  if (s != expected)
+  {
+    std::cout << "Vector add failed for " << kind << " checksum " << s << " expected " << expected << std::endl;
+    exit(-1);
+  }
+
+  pool.release(a);
+  pool.release(b);
+  pool.release(sum);
+  dev.pool(usm::alloc::host).release(host_sum);
+  return timer;
+}
+
+int main(int argc, char* argv[]) {
+
+  config conf = ParseInputParams (argc, argv);
+
+  std::vector<int> a_in(conf.vector_size), b_in(conf.vector_size);
+  for (size_t i = 0; i < conf.vector_size; i++) a_in[i] = b_in[i] = i;
+
+  std::ofstream myfile(conf.filename, std::ios_base::app);
+  if (myfile.tellp() == 0)
+    myfile << "benchmark;datasize;device;alloc;time_ms_event;time_ms_chrono" << std::endl;
+
+  try {
+    auto &dev = coprocessing_runtime::instance().get(conf.device_str);
+    std::cout << "Running on device: "
+             << dev.q.get_device().get_info<info::device::name>() << "\n";
+
+    for (std::string kind : {"shared", "shared_staged", "host", "device"})
+    {
+      //warmup RUN!
+      run_kind(dev, kind, a_in, b_in, conf.vector_size);
+      for (int r = 0; r < conf.repetitions; r++)
+      {
+        times timer = run_kind(dev, kind, a_in, b_in, conf.vector_size);
+        std::cout << kind << " event " << timer.runtime_event_ms / 1000000 << " ms chrono "
+                  << timer.runtime_chrono_ms / 1000 << " ms" << std::endl;
+        myfile << "usm_kinds" << ";" << conf.vector_size
+        << ";" << conf.device_str
+        << ";" << kind
+        << ";" << timer.runtime_event_ms / 1000000 << ";" << timer.runtime_chrono_ms / 1000
+        << std::endl;
+      }
+    }
+  } catch (exception const &e) {
+    std::cout << "An exception is caught while adding two vectors.\n";
+    std::terminate();
+  }
+  return 0;
+}
@@ -0,0 +1,161 @@
+#ifndef VALIDATION_HPP
+#define VALIDATION_HPP
+
+#include <sycl/sycl.hpp>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <omp.h>
+
+using namespace sycl;
+
+/**
+ * How a co-processed VectorAdd result is checked:
+ * none     no check (--nv)
+ * serial   recompute into a full size sum_sequential array, then compare serially
+ * full     parallel compare against a[i] + b[i] computed on the fly, no extra array
+ * sampled  compare a fixed number of pseudo random indices plus both partition borders
+ * checksum position weighted checksum, the device partition is reduced on the
+ *          device so its result pages are not pulled back to the host
+ */
+enum class validation_mode { none, serial, full, sampled, checksum };
+
+inline validation_mode parse_validation_mode(const char *s)
+{
+  if (strcmp(s, "none") == 0) return validation_mode::none;
+  if (strcmp(s, "serial") == 0) return validation_mode::serial;
+  if (strcmp(s, "sampled") == 0) return validation_mode::sampled;
+  if (strcmp(s, "checksum") == 0) return validation_mode::checksum;
+  if (strcmp(s, "full") == 0) return validation_mode::full;
+  //a typo must not silently pick a mode
+  std::cout << "unknown validation mode " << s << ", use none, serial, full, sampled or checksum" << std::endl;
+  exit(-1);
+}
+
+inline const char *validation_mode_name(validation_mode m)
+{
+  switch (m)
+  {
+    case validation_mode::none: return "none";
+    case validation_mode::serial: return "serial";
+    case validation_mode::sampled: return "sampled";
+    case validation_mode::checksum: return "checksum";
+    default: return "full";
+  }
+}
+
+//extra memory the mode needs on top of the benchmark arrays
+inline size_t validation_extra_bytes(validation_mode m, size_t size)
+{
+  return m == validation_mode::serial ? size * sizeof(int) : 0;
+}
+
+//parallel compare, reports the smallest failing index
+inline bool validate_add_full(const int *a, const int *b, const int *result, size_t size, int omp_threads)
+{
+  size_t first_bad = size;
+  #pragma omp parallel for num_threads(omp_threads) reduction(min : first_bad)
+  for (size_t i = 0; i < size; i++)
+    if (result[i] != a[i] + b[i] && i < first_bad) first_bad = i;
+
+  if (first_bad < size)
+  {
+    std::cout << "Vector add failed on device. at index " << first_bad << "\n";
+    std::cout << " device |  host " << result[first_bad] << " " << a[first_bad] + b[first_bad] << std::endl;
+    return false;
+  }
+  return true;
+}
+
+inline bool validate_add_sampled(const int *a, const int *b, const int *result, size_t size,
+                                 size_t start_index, size_t samples)
+{
+  auto check = [&](size_t i) {
+    if (i >= size || result[i] == a[i] + b[i]) return true;
+    std::cout << "Vector add failed on device. at index " << i << "\n";
+    std::cout << " device |  host " << result[i] << " " << a[i] + b[i] << std::endl;
+    return false;
+  };
+
+  //both ends and both sides of the cpu/device border are the likely off-by-one spots
+  for (size_t i : {size_t(0), size - 1, start_index - 1, start_index})
+    if (!check(i)) return false;
+
+  uint64_t x = 0x9E3779B97F4A7C15ull;
+  for (size_t s = 0; s < samples && size > 0; s++)
+  {
+    x = x * 6364136223846793005ull + 1442695040888963407ull;
+    if (!check((x >> 16) % size)) return false;
+  }
+  return true;
+}
+
+/**
+ * sum of v[i] * (2i + 1) over [begin, end), wrapping 64 bit. the weight makes
+ * swapped elements change the result
+ */
+inline uint64_t host_checksum(const int *result, size_t begin, size_t end, int omp_threads)
+{
+  uint64_t s = 0;
+  #pragma omp parallel for num_threads(omp_threads) reduction(+ : s)
+  for (size_t i = begin; i < end; i++) s += (uint64_t)(int64_t)result[i] * (2 * i + 1);
+  return s;
+}
+
+inline uint64_t device_checksum(queue &q, const int *result, size_t begin, size_t end)
+{
+  uint64_t *s = malloc_shared<uint64_t>(1, q);
+  *s = 0;
+  q.submit([&](handler &h) {
+    h.parallel_for(range<1>{end - begin}, reduction(s, plus<uint64_t>()), [=](id<1> idx, auto &acc) {
+      size_t i = begin + idx;
+      acc += (uint64_t)(int64_t)result[i] * (2 * i + 1);
+    });
+  }).wait();
+  uint64_t r = *s;
+  free(s, q);
+  return r;
+}
+
+inline bool validate_add_checksum(queue &q, const int *a, const int *b, const int *result, size_t size,
+                                  size_t start_index, int omp_threads)
+{
+  size_t split = start_index < size ? start_index : size;
+  uint64_t expected = 0;
+  #pragma omp parallel for num_threads(omp_threads) reduction(+ : expected)
+  for (size_t i = 0; i < size; i++) expected += (uint64_t)(int64_t)(a[i] + b[i]) * (2 * i + 1);
+
+  uint64_t got = host_checksum(result, 0, split, omp_threads);
+  if (split < size) got += device_checksum(q, result, split, size);
+  if (got != expected)
+  {
+    std::cout << "Vector add failed on device. checksum " << got << " expected " << expected << "\n";
+    return false;
+  }
+  return true;
+}
+
+/**
+ * run the check selected by mode, serial is left to the caller since it
+ * needs the sum_sequential array. prints time taken and extra memory used
+ */
+inline bool validate_add(validation_mode mode, queue &q, const int *a, const int *b, const int *result,
+                         size_t size, size_t start_index, int omp_threads, size_t samples = 4096)
+{
+  auto t1 = std::chrono::steady_clock::now();
+  bool valid = true;
+  if (mode == validation_mode::sampled) valid = validate_add_sampled(a, b, result, size, start_index, samples);
+  else if (mode == validation_mode::checksum) valid = validate_add_checksum(q, a, b, result, size, start_index, omp_threads);
+  else if (mode != validation_mode::none) valid = validate_add_full(a, b, result, size, omp_threads);
+  auto t2 = std::chrono::steady_clock::now();
+
+  std::cout << "Validation " << validation_mode_name(mode) << ": "
+            << std::chrono::duration_cast<std::chrono::microseconds>(t2 - t1).count() << " us, extra memory "
+            << validation_extra_bytes(mode, size) << " bytes (serial needs "
+            << validation_extra_bytes(validation_mode::serial, size) << ")" << std::endl;
+  return valid;
+}
+
+#endif // VALIDATION_HPP
@@ -24,6 +24,8 @@
 #include <iostream>
 #include <fstream>
 #include <string>
+#include <algorithm>
+#include <chrono>
 #if FPGA_HARDWARE || FPGA_EMULATOR || FPGA_SIMULATOR
 #include <sycl/ext/intel/fpga_extensions.hpp>
 #endif
@@ -83,10 +85,51 @@ double  CopyVec(queue &q, const IntVector &a_vector,
     });
   
   // Wait until compute tasks on GPU done
-  //q.wait();
- // return(e.template get_profiling_info<info::event_profiling::command_end>() -
-  //     e.template get_profiling_info<info::event_profiling::command_start>());
-  return -1.;
+  e.wait();
+  return(e.template get_profiling_info<info::event_profiling::command_end>() -
+       e.template get_profiling_info<info::event_profiling::command_start>());
+}
+
+// STREAM scale: sum = scalar * a
+double  ScaleVec(queue &q, const IntVector &a_vector, int scalar,
+               IntVector &sum_parallel) {
+
+  range<1> num_items{a_vector.size()};
+
+  buffer a_buf(a_vector);
+  buffer sum_buf(sum_parallel.data(), num_items);
+
+    event e = q.submit([&](handler &h) {
+      accessor a(a_buf, h, read_only);
+      accessor sum(sum_buf, h, write_only, no_init);
+      h.parallel_for(num_items, [=](auto i) { sum[i] = scalar * a[i]; });
+    });
+
+  e.wait();
+  return(e.template get_profiling_info<info::event_profiling::command_end>() -
+       e.template get_profiling_info<info::event_profiling::command_start>());
+}
+
+// STREAM triad: sum = a + scalar * b
+double  TriadVec(queue &q, const IntVector &a_vector, const IntVector &b_vector, int scalar,
+               IntVector &sum_parallel) {
+
+  range<1> num_items{a_vector.size()};
+
+  buffer a_buf(a_vector);
+  buffer b_buf(b_vector);
+  buffer sum_buf(sum_parallel.data(), num_items);
+
+    event e = q.submit([&](handler &h) {
+      accessor a(a_buf, h, read_only);
+      accessor b(b_buf, h, read_only);
+      accessor sum(sum_buf, h, write_only, no_init);
+      h.parallel_for(num_items, [=](auto i) { sum[i] = a[i] + scalar * b[i]; });
+    });
+
+  e.wait();
+  return(e.template get_profiling_info<info::event_profiling::command_end>() -
+       e.template get_profiling_info<info::event_profiling::command_start>());
 }
 
 double  VectorAdd(queue &q, const IntVector &a_vector, const IntVector &b_vector,
@@ -122,12 +165,113 @@ double  VectorAdd(queue &q, const IntVector &a_vector, const IntVector &b_vector
     });
   
   // Wait until compute tasks on GPU done
-//  q.wait();
+  e.wait();
   return(e.template get_profiling_info<info::event_profiling::command_end>() -
        e.template get_profiling_info<info::event_profiling::command_start>());
    
 }
 
+// elements per sub-buffer: the size split into parts, rounded up so every
+// sub-buffer offset meets the device base address alignment
+size_t SubBufferChunk(queue &q, size_t size, size_t parts) {
+  size_t align = q.get_device().get_info<info::device::mem_base_addr_align>() / 8 / sizeof(int);
+  align = std::max<size_t>(1, align);
+  size_t chunk = (size + parts - 1) / parts;
+  return (chunk + align - 1) / align * align;
+}
+
+// kernel time of one repetition: first start to last end over its events
+double SpanNs(const std::vector<event> &events) {
+  uint64_t start = UINT64_MAX, end = 0;
+  for (auto &e : events) {
+    start = std::min<uint64_t>(start, e.get_profiling_info<info::event_profiling::command_start>());
+    end = std::max<uint64_t>(end, e.get_profiling_info<info::event_profiling::command_end>());
+  }
+  return end > start ? end - start : 0;
+}
+
+// persistent: buffers live across all num_repetitions kernels and are split
+// into sub-buffers, one submission per part. nothing waits between the
+// repetitions, the runtime orders them through the accessors and the data
+// stays on the device; inputs are copied in once and sum written back once
+// when the buffers go out of scope. returns mean kernel ns per repetition,
+// runtime_chrono gets the wall time in us including both transfers
+template<typename Op>
+double PersistentVec(queue &q, const IntVector &a_vector, const IntVector &b_vector, IntVector &sum_parallel,
+                     Op op, size_t parts, double &runtime_chrono) {
+  size_t size = a_vector.size();
+  size_t chunk = SubBufferChunk(q, size, parts);
+  std::vector<std::vector<event>> events(num_repetitions);
+
+  auto t1 = std::chrono::steady_clock::now();
+  {
+    buffer<int, 1> a_buf(a_vector.data(), range<1>{size});
+    buffer<int, 1> b_buf(b_vector.data(), range<1>{size});
+    buffer<int, 1> sum_buf(sum_parallel.data(), range<1>{size});
+
+    std::vector<buffer<int, 1>> a_sub, b_sub, sum_sub;
+    for (size_t off = 0; off < size; off += chunk) {
+      size_t len = std::min(chunk, size - off);
+      a_sub.push_back(buffer<int, 1>(a_buf, id<1>{off}, range<1>{len}));
+      b_sub.push_back(buffer<int, 1>(b_buf, id<1>{off}, range<1>{len}));
+      sum_sub.push_back(buffer<int, 1>(sum_buf, id<1>{off}, range<1>{len}));
+    }
+
+    for (size_t r = 0; r < num_repetitions; r++)
+      for (size_t p = 0; p < sum_sub.size(); p++)
+        events[r].push_back(q.submit([&](handler &h) {
+          accessor a(a_sub[p], h, read_only);
+          accessor b(b_sub[p], h, read_only);
+          accessor sum(sum_sub[p], h, write_only, no_init);
+          h.parallel_for(range<1>{sum_sub[p].size()}, [=](auto i) { sum[i] = op(a[i], b[i]); });
+        }));
+    q.wait();
+  }
+  auto t2 = std::chrono::steady_clock::now();
+  runtime_chrono = std::chrono::duration_cast<std::chrono::microseconds>(t2 - t1).count();
+
+  double kernel_ns = 0;
+  for (auto &e : events) kernel_ns += SpanNs(e);
+  return kernel_ns / num_repetitions;
+}
+
+// usm: the usm_add path, malloc_shared inputs and output, filled and read
+// back by the host once around num_repetitions kernels chained by events
+template<typename Op>
+double UsmVec(queue &q, const IntVector &a_vector, const IntVector &b_vector, IntVector &sum_parallel,
+              Op op, double &runtime_chrono) {
+  size_t size = a_vector.size();
+  std::vector<event> events;
+
+  auto t1 = std::chrono::steady_clock::now();
+  int *a = malloc_shared<int>(size, q);
+  int *b = malloc_shared<int>(size, q);
+  int *sum = malloc_shared<int>(size, q);
+  if (a == nullptr || b == nullptr || sum == nullptr) {
+    std::cout << "Shared memory allocation failure.\n";
+    exit(-1);
+  }
+  std::copy(a_vector.begin(), a_vector.end(), a);
+  std::copy(b_vector.begin(), b_vector.end(), b);
+
+  event prev;
+  for (size_t r = 0; r < num_repetitions; r++) {
+    prev = q.parallel_for(range<1>{size}, prev, [=](auto i) { sum[i] = op(a[i], b[i]); });
+    events.push_back(prev);
+  }
+  q.wait();
+  std::copy(sum, sum + size, sum_parallel.begin());
+  free(a, q);
+  free(b, q);
+  free(sum, q);
+  auto t2 = std::chrono::steady_clock::now();
+  runtime_chrono = std::chrono::duration_cast<std::chrono::microseconds>(t2 - t1).count();
+
+  double kernel_ns = 0;
+  for (auto &e : events) kernel_ns += SpanNs({e});
+  return kernel_ns / num_repetitions;
+}
+
 //************************************
 // Initialize the vector from 0 to vector_size - 1
 //************************************
@@ -140,18 +284,22 @@ void InitializeVector(IntVector &a) {
 //************************************
 int main(int argc, char* argv[]) {
   // Change num_repetitions if it was passed as argument
-  std::string kernel = "nosync_add";
+  // kernel: add (default), copy, scale or triad
+  std::string kernel = "add";
   if (argc > 2) kernel = argv[2];
-
-  if(kernel == "add")
-  {
-    std::cout<<"nosync_add"<<std::endl;
-  }
-
-  else if (kernel == "copy")
-  {
-  std::cout<<"copy"<<std::endl;
+  std::cout<<kernel<<std::endl;
+  // mode: percall (default) builds buffers per call, persistent keeps them
+  // with sub-buffers, usm runs the usm_add path, all runs the three in a row
+  std::string mode = "percall";
+  if (argc > 3) mode = argv[3];
+  if (mode != "percall" && mode != "persistent" && mode != "usm" && mode != "all") {
+    std::cout << "unknown mode " << mode << ", use percall, persistent, usm or all" << std::endl;
+    return -1;
   }
+  if (argc > 4) num_repetitions = std::max(1, std::stoi(argv[4]));
+  // sub-buffers per persistent buffer
+  size_t parts = 1;
+  if (argc > 5) parts = std::max(1, std::stoi(argv[5]));
 
   
 
@@ -189,13 +337,49 @@ int main(int argc, char* argv[]) {
     std::cout << "Vector size: " << a.size() << "\n";
 
  
-        auto t1 = std::chrono::steady_clock::now();
-      runtime_event=VectorAdd(q, a, b, sum_parallel);
-        auto t2 = std::chrono::steady_clock::now();
-    
-  
-    
-    
+  // kernels of the persistent and usm modes, same arithmetic as the per call functions
+  auto run = [&](const std::string &m, auto op) {
+    if (m == "persistent") return PersistentVec(q, a, b, sum_parallel, op, parts, runtime_chrono);
+    if (m == "usm") return UsmVec(q, a, b, sum_parallel, op, runtime_chrono);
+    double event_ns = 0;
+    auto t1 = std::chrono::steady_clock::now();
+    for (size_t r = 0; r < num_repetitions; r++) {
+      if (kernel == "copy") event_ns += CopyVec(q, a, sum_parallel);
+      else if (kernel == "scale") event_ns += ScaleVec(q, a, 3, sum_parallel);
+      else if (kernel == "triad") event_ns += TriadVec(q, a, b, 3, sum_parallel);
+      else event_ns += VectorAdd(q, a, b, sum_parallel);
+    }
+    auto t2 = std::chrono::steady_clock::now();
+    runtime_chrono = std::chrono::duration_cast<std::chrono::microseconds>(t2 - t1).count();
+    return event_ns / num_repetitions;
+  };
+
+  std::vector<std::string> modes{mode};
+  if (mode == "all") modes = {"percall", "persistent", "usm"};
+
+  for (auto &m : modes) {
+    std::fill(sum_parallel.begin(), sum_parallel.end(), 0);
+    if (kernel == "copy") runtime_event = run(m, [](int x, int) { return x; });
+    else if (kernel == "scale") runtime_event = run(m, [](int x, int) { return 3 * x; });
+    else if (kernel == "triad") runtime_event = run(m, [](int x, int y) { return x + 3 * y; });
+    else runtime_event = run(m, [](int x, int y) { return x + y; });
+
+    for (size_t i = 0; i < vector_size; i++) {
+      int expected = kernel == "copy" ? a[i] : kernel == "scale" ? 3 * a[i] : kernel == "triad" ? a[i] + 3 * b[i] : a[i] + b[i];
+      if (sum_parallel[i] != expected) {
+        std::cout << m << " failed at index " << i << std::endl;
+        return -1;
+      }
+    }
+
+    // STREAM byte count: copy and scale move two arrays, add and triad three
+    double arrays = (kernel == "copy" || kernel == "scale") ? 2 : 3;
+    double throughput = arrays * vector_size * sizeof(int) / runtime_event; // GB/s of the kernel
+    // wall time per repetition, transfers and buffer construction amortized
+    double chrono_per_rep = runtime_chrono / num_repetitions;
+    std::cout << m << ": kernel ms " << runtime_event / 1000000 << ", wall ms per repetition "
+              << chrono_per_rep / 1000 << std::endl;
+
 //output
   //std::string filename = kernel+std::to_string(mib)+"gpu.csv";
    std::string filename = "add_gpu.csv";
@@ -203,7 +387,6 @@ int main(int argc, char* argv[]) {
     myfile.open(filename);
 
     
-    runtime_chrono=std::chrono::duration_cast<std::chrono::microseconds>(t2 - t1).count();
      if(myfile.peek() == std::ifstream::traits_type::eof())
     {
 
@@ -219,7 +402,10 @@ int main(int argc, char* argv[]) {
     myfile.open(filename);
     myfile.seekg (0, std::ios::end);
 
-    myfile <<kernel<<";"<< vector_size<<";"<<runtime_event /1000000<<";"<<runtime_chrono/1000 <<";-"<<std::endl;
+    // per call rows keep the plain kernel name of earlier runs
+    std::string benchmark = m == "percall" ? kernel : kernel + "_" + m;
+    myfile <<benchmark<<";"<< vector_size<<";"<<runtime_event /1000000<<";"<<chrono_per_rep/1000 <<";"<<throughput<<std::endl;
+  }
 
   int indices[]{0, 1, 2, (static_cast<int>(a.size()) - 1)};
   constexpr size_t indices_size = sizeof(indices) / sizeof(int);